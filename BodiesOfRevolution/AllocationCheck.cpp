@@ -0,0 +1,69 @@
+#include "AllocationCheck.h"
+#include "AllocationCounter.h"
+#include "EditWorker.h"
+#include <math.h>
+#include <iostream>
+
+using namespace std;
+
+// Control points of the checked profile and revolutions of its body
+#define CHECK_POINTS 24
+#define CHECK_REVOLUTIONS 64
+
+static void editCycle(EditWorker& worker, int cycle, Curve& curve, RevolutionMesh& mesh)
+{
+    // The last point is taken off and put back, which rebuilds the curve, then a few are dragged
+    worker.push({ EditCommandType::pop, 0, 0.0, 0.0 });
+    worker.push({ EditCommandType::add, 0, 10.0 * CHECK_POINTS, 20.0 });
+
+    for (int k = 1; k < 4; k++)
+    {
+        int index = (cycle * 7 + k * 5) % CHECK_POINTS;
+        worker.push({ EditCommandType::move, index, 10.0 * index, 60.0 + 25.0 * sin(0.3 * cycle + index) });
+    }
+
+    worker.push({ EditCommandType::buildBody, CHECK_REVOLUTIONS, 0.0, 0.0 });
+    worker.wait();
+
+    worker.receive(curve, mesh);
+}
+
+bool checkAllocations()
+{
+    if (!AllocationCounter::enabled())
+    {
+        cout << "Allocations are not counted in this build, define BOR_COUNT_ALLOCATIONS" << endl;
+        return false;
+    }
+
+    EditWorker worker;
+    worker.start();
+
+    // The render thread keeps its curve like the main loop does
+    Curve curve;
+    RevolutionMesh mesh;
+    curve.reserve(EDIT_RESERVE_POINTS);
+
+    for (int i = 0; i < CHECK_POINTS; i++)
+        worker.push({ EditCommandType::add, 0, 10.0 * i, 60.0 + 25.0 * sin(1.3 * i) });
+
+    for (int cycle = 0; cycle < CHECK_WARMUP_CYCLES; cycle++)
+        editCycle(worker, cycle, curve, mesh);
+
+    long long renderAllocations = 0;
+    for (int cycle = 0; cycle < CHECK_CYCLES; cycle++)
+    {
+        AllocationScope scope;
+        editCycle(worker, CHECK_WARMUP_CYCLES + cycle, curve, mesh);
+        renderAllocations += scope.allocations();
+    }
+
+    worker.stop();
+
+    cout << CHECK_CYCLES << " edit cycles of " << CHECK_POINTS << " points and " << CHECK_REVOLUTIONS << " revolutions, "
+        << worker.meshBuilds << " meshes built" << endl;
+    cout << "Edit batches that allocated without growing: " << worker.allocatingBatches << endl;
+    cout << "Render thread allocations: " << renderAllocations << endl;
+
+    return worker.allocatingBatches == 0 && renderAllocations == 0 && mesh.indices.size() > 0;
+}
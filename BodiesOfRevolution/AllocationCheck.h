@@ -0,0 +1,10 @@
+#pragma once
+
+// Edit and publish cycles, the render thread is measured after the warm-up cycles
+#define CHECK_WARMUP_CYCLES 8
+#define CHECK_CYCLES 200
+
+// --check-allocations: drives the edit worker through cycles of adding, removing and moving profile
+// points, meshing the body and handing the results to the calling thread, like the render loop does.
+// Returns false when a cycle allocated on either thread, or when the build does not count allocations.
+bool checkAllocations();
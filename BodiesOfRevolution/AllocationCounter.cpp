@@ -0,0 +1,125 @@
+#include "AllocationCounter.h"
+
+#ifdef BOR_COUNT_ALLOCATIONS
+
+#include <new>
+#include <stdlib.h>
+
+static thread_local long long g_allocations = 0;
+static thread_local long long g_bytes = 0;
+
+static void* countedAllocate(size_t size)
+{
+    g_allocations++;
+    g_bytes += size;
+
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void* operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    g_allocations++;
+    g_bytes += size;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    g_allocations++;
+    g_bytes += size;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+bool AllocationCounter::enabled()
+{
+    return true;
+}
+
+long long AllocationCounter::allocations()
+{
+    return g_allocations;
+}
+
+long long AllocationCounter::bytes()
+{
+    return g_bytes;
+}
+
+#else
+
+bool AllocationCounter::enabled()
+{
+    return false;
+}
+
+long long AllocationCounter::allocations()
+{
+    return 0;
+}
+
+long long AllocationCounter::bytes()
+{
+    return 0;
+}
+
+#endif
+
+AllocationScope::AllocationScope()
+{
+    this->startAllocations = AllocationCounter::allocations();
+    this->startBytes = AllocationCounter::bytes();
+}
+
+long long AllocationScope::allocations() const
+{
+    return AllocationCounter::allocations() - this->startAllocations;
+}
+
+long long AllocationScope::bytes() const
+{
+    return AllocationCounter::bytes() - this->startBytes;
+}
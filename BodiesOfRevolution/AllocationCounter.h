@@ -0,0 +1,32 @@
+#pragma once
+#include <stddef.h>
+
+// Heap allocation counting for finding allocations on the edit path. With BOR_COUNT_ALLOCATIONS
+// defined the global operator new is replaced and every thread counts its own allocations,
+// otherwise the counters stay at zero and nothing is replaced.
+
+class AllocationCounter
+{
+public:
+    // True when the build counts allocations
+    static bool enabled();
+
+    static long long allocations();
+
+    static long long bytes();
+};
+
+// Allocations made by the current thread during the lifetime of the scope
+class AllocationScope
+{
+public:
+    AllocationScope();
+
+    long long allocations() const;
+
+    long long bytes() const;
+
+private:
+    long long startAllocations;
+    long long startBytes;
+};
@@ -0,0 +1,245 @@
+#include "Benchmark.h"
+#include "MeshKernels.h"
+#include "SimdMath.h"
+#include "Matrix.h"
+#include "tbezier.h"
+#include <math.h>
+#include <chrono>
+#include <iostream>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Fastest of BENCH_RUNS calls, in milliseconds
+template <typename Body>
+static double bestTime(const Body& body)
+{
+    double best = 1.0e300;
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        auto start = chrono::steady_clock::now();
+        body();
+        double time = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (time < best)
+            best = time;
+    }
+    return best;
+}
+
+// Deterministic profile with chords of varying length and direction
+static void makeProfile(int count, vector<Point2D>& values)
+{
+    values.resize(count);
+    for (int i = 0; i < count; i++)
+        values[i] = Point2D(i * 0.5 + 0.3 * sin(i * 0.71), 100.0 + 50.0 * sin(i * 0.013) + 5.0 * sin(i * 0.37));
+}
+
+static bool benchTbezier()
+{
+    cout << "tbezierSO0 against tbezierSO0Parallel, " << thread::hardware_concurrency() << " hardware threads" << endl;
+
+    bool result = true;
+    vector<Point2D> values;
+    vector<Segment> serial, parallel;
+
+    for (int count : { 4096, 16384, 131072, 1048576, 2097152 })
+    {
+        makeProfile(count, values);
+
+        double serialTime = bestTime([&]() { tbezierSO0(values, serial); });
+        double parallelTime = bestTime([&]() { tbezierSO0Parallel(values, parallel, 0); });
+
+        bool same = serial.size() == parallel.size() && memcmp(serial.data(), parallel.data(), serial.size() * sizeof(Segment)) == 0;
+        result = result && same;
+
+        cout << "  " << count << " points: serial " << serialTime << " ms, parallel " << parallelTime << " ms, speedup "
+            << serialTime / parallelTime << (same ? "" : ", RESULTS DIFFER") << endl;
+    }
+
+    return result;
+}
+
+static bool benchKernels()
+{
+    bool result = true;
+
+    vector<Point2D> values;
+    vector<Segment> segments;
+    makeProfile(200001, values);
+    tbezierSO0(values, segments);
+
+    cout << "sampleSegmentFixed against sampleSegmentGeneric, " << segments.size() << " segments" << endl;
+
+    for (int samples : { 8, 16, 32 })
+    {
+        SampleKernel kernel = findSampleKernel(samples);
+        vector<Point2D> genericPoints(samples), genericTangents(samples), fixedPoints(samples), fixedTangents(samples);
+
+        // Only the last segment is kept, it is read by the comparison below
+        double genericTime = bestTime([&]()
+        {
+            for (const Segment& segment : segments)
+                sampleSegmentGeneric(segment, samples, genericPoints.data(), genericTangents.data());
+        });
+        double fixedTime = bestTime([&]()
+        {
+            for (const Segment& segment : segments)
+                kernel(segment, fixedPoints.data(), fixedTangents.data());
+        });
+
+        // Every segment is compared outside the timed loops
+        bool same = true;
+        for (const Segment& segment : segments)
+        {
+            sampleSegmentGeneric(segment, samples, genericPoints.data(), genericTangents.data());
+            kernel(segment, fixedPoints.data(), fixedTangents.data());
+            same = same && memcmp(genericPoints.data(), fixedPoints.data(), samples * sizeof(Point2D)) == 0
+                && memcmp(genericTangents.data(), fixedTangents.data(), samples * sizeof(Point2D)) == 0;
+        }
+        result = result && same;
+
+        cout << "  " << samples << " samples: generic " << genericTime << " ms, fixed " << fixedTime << " ms, speedup "
+            << genericTime / fixedTime << (same ? ", identical" : ", RESULTS DIFFER") << endl;
+    }
+
+    const int rings = 20000;
+    cout << "revolveFixed against revolveGeneric, " << rings << " rings" << endl;
+
+    for (int revolutions : { 32, 64, 128, 256 })
+    {
+        RevolveKernel kernel = findRevolveKernel(revolutions);
+        vector<float> generic(6 * revolutions), fixed(6 * revolutions);
+
+        double genericTime = bestTime([&]()
+        {
+            for (int k = 0; k < rings; k++)
+                revolveGeneric(k * 0.5f, 100.0f, 0.6f, 0.8f, revolutions, generic.data());
+        });
+        double fixedTime = bestTime([&]()
+        {
+            for (int k = 0; k < rings; k++)
+                kernel(k * 0.5f, 100.0f, 0.6f, 0.8f, fixed.data());
+        });
+
+        // The tables round cos and sin differently from libm in the last bits
+        double difference = 0.0;
+        for (int i = 0; i < 6 * revolutions; i++)
+            difference = max(difference, (double)fabs(generic[i] - fixed[i]));
+
+        cout << "  " << revolutions << " revolutions: generic " << genericTime << " ms, fixed " << fixedTime << " ms, speedup "
+            << genericTime / fixedTime << ", largest difference " << difference << endl;
+    }
+
+    return result;
+}
+
+// Largest difference relative to the magnitude of the value, at least 1
+static double largestDifference(const float* a, const float* b, int count)
+{
+    double result = 0.0;
+    for (int i = 0; i < count; i++)
+        result = max(result, fabs((double)a[i] - b[i]) / max(1.0, fabs((double)a[i])));
+    return result;
+}
+
+static bool benchSimdMath()
+{
+    // The tolerance only catches wrong results, SSE products round in a different order
+    const double tolerance = 1.0e-5;
+    const int count = 1024, rounds = 1000;
+
+    cout << "SimdMath against Matrix4 and Vector4, " << count * rounds << " operations" << endl;
+
+    // A model matrix like the body's, with a translation
+    Matrix4 model = createRotateZMatrix(-90.0f) * createScaleMatrix(0.05f, 0.05f, 0.05f);
+    model.elements[3] = 1.0f, model.elements[7] = -2.0f, model.elements[11] = 3.0f;
+    Mat4f fastModel(model.elements);
+
+    vector<Vector3> eyes(count);
+    vector<Matrix4> views(count), products(count);
+    vector<Mat4f> fastViews(count), fastProducts(count);
+    for (int i = 0; i < count; i++)
+    {
+        eyes[i] = Vector3(i * 0.01f, 2.0f + i * 0.002f, 3.0f);
+        views[i] = createLookAtMatrix(eyes[i], Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
+    }
+
+    double scalarTime = bestTime([&]()
+    {
+        for (int r = 0; r < rounds; r++)
+            for (int i = 0; i < count; i++)
+                views[i] = createLookAtMatrix(eyes[i], Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
+    });
+    double simdTime = bestTime([&]()
+    {
+        for (int r = 0; r < rounds; r++)
+            for (int i = 0; i < count; i++)
+                fastViews[i] = Mat4f::lookAt(eyes[i], Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
+    });
+
+    double difference = 0.0;
+    for (int i = 0; i < count; i++)
+        difference = max(difference, largestDifference(views[i].elements, fastViews[i].m, 16));
+    bool result = difference <= tolerance;
+
+    cout << "  lookAt: Matrix4 " << scalarTime << " ms, Mat4f " << simdTime << " ms, speedup " << scalarTime / simdTime
+        << ", largest difference " << difference << endl;
+
+    scalarTime = bestTime([&]()
+    {
+        for (int r = 0; r < rounds; r++)
+            for (int i = 0; i < count; i++)
+                products[i] = views[i] * model;
+    });
+    simdTime = bestTime([&]()
+    {
+        for (int r = 0; r < rounds; r++)
+            for (int i = 0; i < count; i++)
+                fastProducts[i] = fastViews[i] * fastModel;
+    });
+
+    difference = 0.0;
+    for (int i = 0; i < count; i++)
+        difference = max(difference, largestDifference(products[i].elements, fastProducts[i].m, 16));
+    result = result && difference <= tolerance;
+
+    cout << "  matrix product: Matrix4 " << scalarTime << " ms, Mat4f " << simdTime << " ms, speedup " << scalarTime / simdTime
+        << ", largest difference " << difference << endl;
+
+    // Points go through Vector4 one at a time, like the mesher did before it worked in profile space
+    vector<float> points(3 * count * rounds), transformed(points.size()), fastTransformed(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+        points[i] = (float)sin(i * 0.37) * 100.0f;
+
+    scalarTime = bestTime([&]()
+    {
+        for (int i = 0; i < count * rounds; i++)
+        {
+            Vector4 p = model * Vector4(points[3 * i], points[3 * i + 1], points[3 * i + 2], 1.0f);
+            transformed[3 * i] = p[0], transformed[3 * i + 1] = p[1], transformed[3 * i + 2] = p[2];
+        }
+    });
+    simdTime = bestTime([&]() { transformPoints(fastModel, points.data(), fastTransformed.data(), count * rounds); });
+
+    difference = largestDifference(transformed.data(), fastTransformed.data(), transformed.size());
+    result = result && difference <= tolerance;
+
+    cout << "  point transform: Vector4 " << scalarTime << " ms, transformPoints " << simdTime << " ms, speedup "
+        << scalarTime / simdTime << ", largest difference " << difference << endl;
+
+    return result;
+}
+
+bool runBenchmarks()
+{
+    cout << "Fastest of " << BENCH_RUNS << " runs" << endl;
+
+    bool result = benchTbezier();
+    result = benchKernels() && result;
+    result = benchSimdMath() && result;
+
+    cout << (result ? "All results match" : "Some results differ") << endl;
+    return result;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Repeats of every measurement, the fastest run is reported
+#define BENCH_RUNS 5
+
+// --bench: times the optimized code paths against the plain ones they replace and prints the results.
+// Returns false when an optimized path gives a different result.
+bool runBenchmarks();
@@ -4,25 +4,72 @@
 #include <vector>
 #include "tbezier.h"
 #include "Matrix.h"
+#include "RevolutionMesh.h"
+#include "SimdMath.h"
+
+// Blinn-Phong shading of the body, shared by the mesh and the tessellation renderers
+#define BODY_FRAGMENT_SHADER \
+    "#version 330\n" \
+    "" \
+    "in vec3 v_normal;" \
+    "in vec3 v_position;" \
+    "" \
+    "layout(location = 0) out vec4 o_color;" \
+    "" \
+    "void main()" \
+    "{" \
+    "   vec3 color = vec3(0.0, 1.0, 0.13);" \
+    "" \
+    "   vec3 E = vec3(0.0, 0.0, 0.0);" \
+    "   vec3 L = vec3(5.0, 5.0, 0.0);" \
+    "   float S = 64.0;" \
+    "" \
+    "   vec3 n = normalize(v_normal);" \
+    "   vec3 l = normalize(L - v_position);" \
+    "" \
+    "   float d = max(dot(n, l), 0.3);" \
+    "" \
+    "   vec3 e = normalize(E - v_position);" \
+    "   vec3 h = normalize(l + e);" \
+    "" \
+    "   float s = pow(max(dot(n, h), 0.0), S);" \
+    "" \
+    "   o_color = vec4(color * d + s * vec3(1.0, 1.0, 1.0), 1.0);" \
+    "   o_color.rgb = pow(o_color.rgb, vec3(1.0 / 2.2));" \
+    "}"
 
 class BodyOfRevolution
 {
 public:
     GLuint shaderProgram;
-    GLint uMVP;
     GLint uMV;
     GLint uN;
-    Model model;
+    GLint uClipPlane;
+    Model model{ MemorySubsystem::body };
+
+    int revolutions = 128;
+
+    // Profile space plane, the body is drawn where dot(clipPlane, (p, 1)) >= 0 while
+    // GL_CLIP_DISTANCE0 is enabled
+    float clipPlane[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
 
     bool bodyCreated = false;
 
+    // Set when the body model changes, cleared by the main loop once the change is on screen
+    bool dirty = false;
+
     bool createShaderProgram();
 
-    bool createModel(const std::vector<Point2D>& points);
+    bool createModel(const RevolutionMesh& mesh);
+
+    // Replaces the geometry of an existing model, e.g. with a simplified mesh
+    void updateModel(const RevolutionMesh& mesh);
+
+    void createBodyOfRevolution(const RevolutionMesh& mesh, Vector3& cameraPos);
 
-    void createBodyOfRevolution(const std::vector<Point2D>& points, Vector3& cameraPos);
+    Matrix4 getModelMatrix();
 
-    void draw(double deltaTime, Matrix4& perspective, Vector3& cameraPos, Vector3& cameraFront, Vector3& cameraUp);
+    void draw(double deltaTime, const Mat4f& view);
 
     void cleanup();
 };
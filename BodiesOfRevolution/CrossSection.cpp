@@ -0,0 +1,349 @@
+#include "CrossSection.h"
+#include "Tools.h"
+#include "FrameUniforms.h"
+#include "GLState.h"
+#include <algorithm>
+#include <chrono>
+
+#define SECTION_BISECTIONS 40
+
+static const double TWO_PI = 6.283185307179586;
+
+// Planes closer than this to perpendicular cut the body in circles
+#define SECTION_PERPENDICULAR 1.0e-6
+
+// Parameter in [u0, u1] where f changes sign, f(u0) and f(u1) having different signs
+template<class F>
+static double bisect(const Segment& s, double u0, double u1, F f)
+{
+    bool negative0 = f(s.calc(u0)) < 0.0;
+
+    for (int i = 0; i < SECTION_BISECTIONS; i++)
+    {
+        double u = (u0 + u1) / 2;
+        if ((f(s.calc(u)) < 0.0) == negative0)
+            u0 = u;
+        else
+            u1 = u;
+    }
+
+    return (u0 + u1) / 2;
+}
+
+bool CrossSection::create()
+{
+    if (!createShaderProgram())
+        return false;
+
+    if (!this->model.create(false))
+        return false;
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (const GLvoid*)0);
+
+    GLState::bindVertexArray(0);
+
+    return true;
+}
+
+void CrossSection::build(const std::vector<Segment>& segments, const double worldPlane[4], Matrix4& model)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    this->vertices.clear();
+    this->loopFirst.clear();
+    this->loopCount.clear();
+    this->upper.clear();
+    this->lower.clear();
+
+    // A plane transforms with the model matrix on the right, the matrix is stored row by row
+    double p[4];
+    for (int j = 0; j < 4; j++)
+    {
+        p[j] = 0.0;
+        for (int i = 0; i < 4; i++)
+            p[j] += worldPlane[i] * model.elements[4 * i + j];
+    }
+
+    double length = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    if (IS_ZERO(length) || segments.empty())
+        return;
+
+    this->a = p[0] / length;
+    this->b = p[1] / length;
+    this->c = p[2] / length;
+    this->w = p[3] / length;
+
+    this->plane[0] = this->a;
+    this->plane[1] = this->b;
+    this->plane[2] = this->c;
+    this->plane[3] = this->w;
+
+    // b y + c z = m r cos(angle - phi) on the circle of radius r
+    this->m = sqrt(this->b * this->b + this->c * this->c);
+    this->phi = atan2(this->c, this->b);
+
+    if (this->m < SECTION_PERPENDICULAR)
+        addCircles(segments);
+    else
+    {
+        // Every run of profile points the plane reaches becomes one loop: the upper branch
+        // forward, the lower branch back. Runs ending at a profile end are closed by the cap chord.
+        bool inside = false;
+        for (int i = 0; i < (int)segments.size(); i++)
+        {
+            const Segment& s = segments[i];
+
+            double u0 = 0.0;
+            double r0 = reach(s.calc(0.0));
+
+            if (i == 0 && r0 >= 0.0)
+            {
+                addPoint(s.calc(0.0), false);
+                inside = true;
+            }
+
+            for (int k = 1; k <= SECTION_SAMPLES; k++)
+            {
+                double u1 = (double)k / SECTION_SAMPLES;
+                double r1 = reach(s.calc(u1));
+
+                if (r0 >= 0.0 && r1 >= 0.0)
+                    addSpan(s, u0, u1, false, 0);
+                else if (r0 < 0.0 && r1 >= 0.0)
+                {
+                    double u = bisect(s, u0, u1, [this](const Point2D& q) { return reach(q); });
+                    addPoint(s.calc(u), true);
+                    addSpan(s, u, u1, false, 0);
+                    inside = true;
+                }
+                else if (r0 >= 0.0 && r1 < 0.0)
+                {
+                    double u = bisect(s, u0, u1, [this](const Point2D& q) { return reach(q); });
+                    addSpan(s, u0, u, true, 0);
+                    closeLoop();
+                    inside = false;
+                }
+
+                u0 = u1;
+                r0 = r1;
+            }
+        }
+
+        if (inside)
+            closeLoop();
+    }
+
+    if (!this->vertices.empty())
+        this->model.uploadVertices(this->vertices.data(), this->vertices.size() * sizeof(GLfloat), GL_STREAM_DRAW);
+
+    this->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CrossSection::draw(const Mat4f& model)
+{
+    if (this->loopFirst.empty())
+        return;
+
+    GLState::useProgram(this->shaderProgram);
+    GLState::bindVertexArray(this->model.vao);
+
+    glUniformMatrix4fv(this->uModel, 1, GL_TRUE, model.m);
+
+    // The body in front of the plane is clipped away, so nothing can hide the cap or the outline
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_STENCIL_TEST);
+
+    // Even-odd fill: every loop is drawn as a fan that inverts the stencil, odd pixels are inside.
+    // The second pass colors them and clears the stencil for the next frame.
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glStencilFunc(GL_ALWAYS, 0, 1);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+    glMultiDrawArrays(GL_TRIANGLE_FAN, this->loopFirst.data(), this->loopCount.data(), this->loopFirst.size());
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glStencilFunc(GL_NOTEQUAL, 0, 1);
+    glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
+    glUniform3f(this->uColor, 0.85f, 0.3f, 0.2f);
+    glMultiDrawArrays(GL_TRIANGLE_FAN, this->loopFirst.data(), this->loopCount.data(), this->loopFirst.size());
+
+    glDisable(GL_STENCIL_TEST);
+
+    glUniform3f(this->uColor, 1.0f, 1.0f, 0.0f);
+    glMultiDrawArrays(GL_LINE_LOOP, this->loopFirst.data(), this->loopCount.data(), this->loopFirst.size());
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+void CrossSection::cleanup()
+{
+    if (this->shaderProgram != 0)
+        GLState::deleteProgram(this->shaderProgram);
+
+    this->model.release();
+}
+
+long long CrossSection::memoryBytes() const
+{
+    return vectorBytes(this->vertices) + vectorBytes(this->loopFirst) + vectorBytes(this->loopCount)
+        + vectorBytes(this->upper) + vectorBytes(this->lower);
+}
+
+bool CrossSection::createShaderProgram()
+{
+    this->shaderProgram = 0;
+
+    const GLchar vsh[] =
+        "#version 330\n"
+        ""
+        "layout(location = 0) in vec3 a_position;"
+        ""
+        CAMERA_BLOCK
+        ""
+        "uniform mat4 u_model;"
+        ""
+        "void main()"
+        "{"
+        "    gl_Position = u_viewProjection * u_model * vec4(a_position, 1.0);"
+        "}"
+        ;
+
+    const GLchar fsh[] =
+        "#version 330\n"
+        ""
+        "uniform vec3 u_color;"
+        ""
+        "layout(location = 0) out vec4 o_color;"
+        ""
+        "void main()"
+        "{"
+        "    o_color = vec4(u_color, 1.0);"
+        "}"
+        ;
+
+    GLuint vertexShader, fragmentShader;
+
+    vertexShader = createShader(vsh, GL_VERTEX_SHADER);
+    fragmentShader = createShader(fsh, GL_FRAGMENT_SHADER);
+
+    if (vertexShader != 0 && fragmentShader != 0)
+        this->shaderProgram = createProgram(vertexShader, fragmentShader);
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    // Compile and link errors are already printed
+    if (this->shaderProgram == 0)
+        return false;
+
+    this->uModel = glGetUniformLocation(this->shaderProgram, "u_model");
+    this->uColor = glGetUniformLocation(this->shaderProgram, "u_color");
+
+    FrameUniforms::bind(this->shaderProgram);
+
+    return true;
+}
+
+double CrossSection::reach(const Point2D& p) const
+{
+    return this->m * p.y - fabs(this->a * p.x + this->w);
+}
+
+void CrossSection::branchPoints(const Point2D& p, double up[3], double low[3]) const
+{
+    double r = std::max(p.y, 0.0);
+
+    // cos(angle - phi) = k on the circle, clamped against rounding at the crossings
+    double k = IS_ZERO(r) ? 0.0 : -(this->a * p.x + this->w) / (r * this->m);
+    double t = acos(std::min(std::max(k, -1.0), 1.0));
+
+    up[0] = low[0] = p.x;
+    up[1] = r * cos(this->phi + t);
+    up[2] = r * sin(this->phi + t);
+    low[1] = r * cos(this->phi - t);
+    low[2] = r * sin(this->phi - t);
+}
+
+void CrossSection::addSpan(const Segment& s, double u0, double u1, bool crossingEnd, int depth)
+{
+    Point2D p1 = s.calc(u1);
+
+    if (depth < SECTION_MAX_DEPTH)
+    {
+        // The branches mirror each other, so the upper one decides
+        double up0[3], up1[3], low[3];
+        branchPoints(s.calc(u0), up0, low);
+        branchPoints(p1, up1, low);
+
+        double dx = up1[0] - up0[0], dy = up1[1] - up0[1], dz = up1[2] - up0[2];
+        if (dx * dx + dy * dy + dz * dz > SECTION_MAX_EDGE * SECTION_MAX_EDGE)
+        {
+            double h = (u0 + u1) / 2;
+            addSpan(s, u0, h, false, depth + 1);
+            addSpan(s, h, u1, crossingEnd, depth + 1);
+            return;
+        }
+    }
+
+    addPoint(p1, crossingEnd);
+}
+
+void CrossSection::addPoint(const Point2D& p, bool crossing)
+{
+    double up[3], low[3];
+    branchPoints(p, up, low);
+
+    for (int i = 0; i < 3; i++)
+        this->upper.push_back(up[i]);
+
+    if (!crossing)
+        for (int i = 0; i < 3; i++)
+            this->lower.push_back(low[i]);
+}
+
+void CrossSection::closeLoop()
+{
+    int count = (this->upper.size() + this->lower.size()) / 3;
+
+    if (count >= 3)
+    {
+        this->loopFirst.push_back(this->vertices.size() / 3);
+        this->loopCount.push_back(count);
+
+        this->vertices.insert(this->vertices.end(), this->upper.begin(), this->upper.end());
+        for (int i = (int)this->lower.size() - 3; i >= 0; i -= 3)
+            this->vertices.insert(this->vertices.end(), this->lower.begin() + i, this->lower.begin() + i + 3);
+    }
+
+    this->upper.clear();
+    this->lower.clear();
+}
+
+void CrossSection::addCircles(const std::vector<Segment>& segments)
+{
+    double x0 = -this->w / this->a;
+    auto side = [x0](const Point2D& q) { return q.x - x0; };
+
+    for (const Segment& s : segments)
+        for (int k = 0; k < SECTION_SAMPLES; k++)
+        {
+            double u0 = (double)k / SECTION_SAMPLES, u1 = (double)(k + 1) / SECTION_SAMPLES;
+            if ((side(s.calc(u0)) < 0.0) == (side(s.calc(u1)) < 0.0))
+                continue;
+
+            double r = s.calc(bisect(s, u0, u1, side)).y;
+            if (r < EPSILON)
+                continue;
+
+            this->loopFirst.push_back(this->vertices.size() / 3);
+            this->loopCount.push_back(SECTION_CIRCLE);
+
+            for (int i = 0; i < SECTION_CIRCLE; i++)
+            {
+                double angle = TWO_PI * i / SECTION_CIRCLE;
+                this->vertices.push_back(x0);
+                this->vertices.push_back(r * cos(angle));
+                this->vertices.push_back(r * sin(angle));
+            }
+        }
+}
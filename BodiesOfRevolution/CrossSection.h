@@ -0,0 +1,74 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include "tbezier.h"
+#include "Matrix.h"
+#include "SimdMath.h"
+#include "Model.h"
+
+// Parameter steps per Bezier segment before the outline is refined
+#define SECTION_SAMPLES 32
+
+// Outline edges longer than this (profile units) are halved, at most SECTION_MAX_DEPTH times
+#define SECTION_MAX_EDGE 2.0
+#define SECTION_MAX_DEPTH 10
+
+// Points of every circle when the plane is perpendicular to the axis
+#define SECTION_CIRCLE 128
+
+// Planar cut through the body computed from the profile segments, no mesh is involved.
+// A plane meets the circle of every profile point in at most two points given in closed form,
+// so the outline is the part of the profile between two lines, mapped back onto the plane.
+// The outline is drawn as line loops and the cap is filled from the loops with the even-odd rule.
+class CrossSection
+{
+public:
+    GLuint shaderProgram = 0;
+    GLint uModel, uColor;
+    Model model{ MemorySubsystem::section };
+
+    // a, b, c, w of a x + b y + c z + w = 0 in profile space, (a, b, c) of unit length.
+    // Points with a positive distance lie behind the plane as seen from the camera.
+    float plane[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    // xyz per vertex in profile space, one closed loop after another
+    std::vector<GLfloat> vertices;
+    std::vector<GLint> loopFirst;
+    std::vector<GLsizei> loopCount;
+
+    double milliseconds = 0.0;
+
+    bool create();
+
+    // worldPlane is given like plane, in world space; model maps profile space to world space
+    void build(const std::vector<Segment>& segments, const double worldPlane[4], Matrix4& model);
+
+    void draw(const Mat4f& model);
+
+    void cleanup();
+
+    long long memoryBytes() const;
+
+private:
+    double a, b, c, w, m, phi;
+
+    std::vector<GLfloat> upper, lower;
+
+    bool createShaderProgram();
+
+    // Positive where the plane meets the circle of the profile point
+    double reach(const Point2D& p) const;
+
+    // The two points where the plane meets the circle of the profile point
+    void branchPoints(const Point2D& p, double up[3], double low[3]) const;
+
+    // Adds the points of (u0, u1] to both branches, halving long edges.
+    // A span ending on a crossing adds its last point once, the branches meet there.
+    void addSpan(const Segment& s, double u0, double u1, bool crossingEnd, int depth);
+
+    void addPoint(const Point2D& p, bool crossing);
+
+    void closeLoop();
+
+    void addCircles(const std::vector<Segment>& segments);
+};
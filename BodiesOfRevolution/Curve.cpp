@@ -1,139 +1,165 @@
 #include "Curve.h"
-#include "Tools.h"
-
-void Curve::updateBuffers()
-{
-    glBindBuffer(GL_ARRAY_BUFFER, this->model.vbo);
-    glBufferData(GL_ARRAY_BUFFER, this->points.size() * sizeof(GLfloat), this->points.data(), GL_DYNAMIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->model.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLint), this->indices.data(), GL_DYNAMIC_DRAW);
-
-    this->model.indexCount = indices.size();
-}
+#include "MeshKernels.h"
+#include <algorithm>
 
 bool Curve::calculateCurvePoints(const std::vector<Point2D>& values)
 {
-    std::vector<Segment> curve;
-    bool res = tbezierSO0(values, curve);
+    bool res = tbezierSO0(values, this->segments);
+
+    if (values.size() == 2)
+    {
+        Point2D direction = values[1] - values[0];
+        direction.normalize();
 
-    this->points.clear();
-    this->indices.clear();
-    this->points2D.clear();
+        // Straight line: keep a linear segment so analytic consumers see the same profile
+        this->segments.resize(1);
+        this->segments[0].points[0] = values[0];
+        this->segments[0].points[1] = values[0] + (values[1] - values[0]) * (1.0 / 3.0);
+        this->segments[0].points[2] = values[0] + (values[1] - values[0]) * (2.0 / 3.0);
+        this->segments[0].points[3] = values[1];
 
-    int k = 0;
+        this->points2D.resize(2);
+        this->tangents2D.resize(2);
 
-    if (values.size() == 2)
         for (int i = 0; i < 2; i++)
         {
-            this->indices.push_back(k++);
-
-            this->points.push_back(values[i].x);
-            this->points.push_back(values[i].y);
-
-            this->points2D.push_back(Point2D(values[i].x, values[i].y));
+            this->points2D[i] = values[i];
+            this->tangents2D[i] = direction;
         }
-    else
-        for (Segment& s : curve)
-            for (int i = 0; i < RESOLUTION; ++i)
-            {
-                Point2D p = s.calc((double)i / (double)RESOLUTION);
-
-                this->indices.push_back(k++);
+    }
+    else if (res)
+    {
+        int count = this->segments.size() * RESOLUTION + 1;
 
-                this->points.push_back(p.x);
-                this->points.push_back(p.y);
+        this->points2D.resize(count);
+        this->tangents2D.resize(count);
 
-                this->points2D.push_back(Point2D(p.x, p.y));
-            }
+        for (int i = 0; i < (int)this->segments.size(); i++)
+            sampleSegment(i);
+    }
+    else
+    {
+        this->segments.clear();
+        this->points2D.clear();
+        this->tangents2D.clear();
+    }
 
-    updateBuffers();
+    this->resized = true;
+    this->dirty = true;
 
     return res;
 }
 
-bool Curve::createModel()
+bool Curve::updateCurvePoints(const std::vector<Point2D>& values, int firstIndex, int lastIndex)
 {
-    glGenVertexArrays(1, &this->model.vao);
-    glBindVertexArray(this->model.vao);
+    int n = values.size() - 1;
+
+    // Short curves and changes of the point count are cheaper to rebuild
+    if (n < 3 || (int)this->segments.size() != n)
+        return calculateCurvePoints(values);
 
-    glGenBuffers(1, &this->model.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, this->model.vbo);
+    // A moved point changes the tangents of its neighbours, so two segments on each side are affected
+    int first = firstIndex - 2 < 0 ? 0 : firstIndex - 2;
+    int last = lastIndex + 2 > n ? n : lastIndex + 2;
 
-    glGenBuffers(1, &this->model.ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->model.ibo);
+    if (!tbezierSO0(values, this->segments, first, last))
+        return false;
 
-    this->model.indexCount = indices.size();
+    for (int i = first; i < last; i++)
+        sampleSegment(i);
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (const GLvoid*)0);
+    // The end point of the last segment closes the profile
+    markDirty(first * RESOLUTION, last == n ? n * RESOLUTION + 1 : last * RESOLUTION);
 
-    return this->model.vbo != 0 && this->model.ibo != 0 && this->model.vao != 0;
+    return true;
 }
 
-bool Curve::createShaderProgram()
+void Curve::reserve(int controlPoints)
 {
-    this->shaderProgram = 0;
-
-    const GLchar vsh[] =
-        "#version 330\n"
-        ""
-        "layout(location = 0) in vec2 a_position;"
-        ""
-        "uniform mat4 u_mvp;"
-        ""
-        "void main()"
-        "{"
-        "    gl_Position = u_mvp * vec4(a_position, 0.0, 1.0);"
-        "}"
-        ;
-
-    const GLchar fsh[] =
-        "#version 330\n"
-        ""
-        "layout(location = 0) out vec4 o_color;"
-        ""
-        "void main()"
-        "{"
-        "    o_color = vec4(0.0, 1.0, 0.0, 1.0);"
-        "}"
-        ;
-
-    GLuint vertexShader, fragmentShader;
-
-    vertexShader = createShader(vsh, GL_VERTEX_SHADER);
-    fragmentShader = createShader(fsh, GL_FRAGMENT_SHADER);
-
-    this->shaderProgram = createProgram(vertexShader, fragmentShader);
-
-    this->uMVP = glGetUniformLocation(this->shaderProgram, "u_mvp");
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return this->shaderProgram != 0;
+    int samples = controlPoints * RESOLUTION + 1;
+
+    this->segments.reserve(controlPoints);
+    this->points2D.reserve(samples);
+    this->tangents2D.reserve(samples);
 }
 
-void Curve::draw(double deltaTime, Matrix4& lookAt, Matrix4& perspective)
+void Curve::assign(Curve& source)
 {
-    glUseProgram(this->shaderProgram);
-    glBindVertexArray(this->model.vao);
+    if (source.resized)
+    {
+        this->points2D = source.points2D;
+        this->tangents2D = source.tangents2D;
+        this->segments = source.segments;
+        this->resized = true;
+        this->dirty = true;
+    }
+    else if (source.dirtyFirst < source.dirtyLast)
+    {
+        int first = source.dirtyFirst, last = source.dirtyLast;
+
+        std::copy(source.points2D.begin() + first, source.points2D.begin() + last, this->points2D.begin() + first);
+        std::copy(source.tangents2D.begin() + first, source.tangents2D.begin() + last, this->tangents2D.begin() + first);
+
+        int lastSegment = (last + RESOLUTION - 1) / RESOLUTION;
+        if (lastSegment > (int)source.segments.size())
+            lastSegment = source.segments.size();
+        std::copy(source.segments.begin() + first / RESOLUTION, source.segments.begin() + lastSegment, this->segments.begin() + first / RESOLUTION);
+
+        markDirty(first, last);
+    }
+
+    source.clearDirty();
+}
 
-    Matrix4 s_umv = perspective * lookAt;
+void Curve::sampleSegment(int index)
+{
+    static const SampleKernel kernel = findSampleKernel(RESOLUTION);
+
+    Segment& s = this->segments[index];
+    Point2D* points = this->points2D.data() + index * RESOLUTION;
+    Point2D* tangents = this->tangents2D.data() + index * RESOLUTION;
+
+    if (kernel != NULL)
+        kernel(s, points, tangents);
+    else
+        sampleSegmentGeneric(s, RESOLUTION, points, tangents);
 
-    glUniformMatrix4fv(this->uMVP, 1, GL_TRUE, s_umv.elements);
+    if (index == (int)this->segments.size() - 1)
+    {
+        int k = (index + 1) * RESOLUTION;
+
+        this->points2D[k] = s.points[3];
+        this->tangents2D[k] = s.tangent(1.0);
+    }
+}
+
+void Curve::markDirty(int first, int last)
+{
+    this->dirty = true;
 
-    glDrawElements(GL_LINE_STRIP, this->model.indexCount, GL_UNSIGNED_INT, NULL);
+    if (this->dirtyFirst >= this->dirtyLast)
+    {
+        this->dirtyFirst = first;
+        this->dirtyLast = last;
+        return;
+    }
+
+    this->dirtyFirst = first < this->dirtyFirst ? first : this->dirtyFirst;
+    this->dirtyLast = last > this->dirtyLast ? last : this->dirtyLast;
+}
+
+void Curve::clearDirty()
+{
+    this->resized = false;
+    this->dirtyFirst = this->dirtyLast = 0;
+}
+
+void Curve::addToOverlay(Overlay& overlay)
+{
+    overlay.addPolyline(this->points2D.data(), this->points2D.size(), 0.0f, 1.0f, 0.0f);
 }
 
-void Curve::cleanup()
+long long Curve::memoryBytes() const
 {
-    if (this->shaderProgram != 0)
-        glDeleteProgram(this->shaderProgram);
-    if (this->model.vbo != 0)
-        glDeleteBuffers(1, &this->model.vbo);
-    if (this->model.ibo != 0)
-        glDeleteBuffers(1, &this->model.ibo);
-    if (this->model.vao != 0)
-        glDeleteVertexArrays(1, &this->model.vao);
+    return vectorBytes(this->points2D) + vectorBytes(this->tangents2D) + vectorBytes(this->segments);
 }
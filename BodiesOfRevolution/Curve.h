@@ -1,30 +1,43 @@
 #pragma once
-#include "Model.h"
 #include <vector>
 #include "tbezier.h"
-#include "Matrix.h"
+#include "Overlay.h"
 
 class Curve
 {
 public:
-    Model model;
-    GLuint shaderProgram;
-    GLint uMVP;
-
-    std::vector<GLfloat> points;
-    std::vector<GLint> indices;
     std::vector<Point2D> points2D;
+    std::vector<Point2D> tangents2D;
+
+    std::vector<Segment> segments;
+
+    // Set on every change of the curve, cleared by the main loop once the change is on screen
+    bool dirty = true;
 
-    void updateBuffers();
+    // Samples changed since the last assign: [dirtyFirst; dirtyLast), or everything when resized
+    bool resized = false;
+    int dirtyFirst = 0;
+    int dirtyLast = 0;
 
     bool calculateCurvePoints(const std::vector<Point2D>& values);
 
-    bool createModel();
+    bool updateCurvePoints(const std::vector<Point2D>& values, int firstIndex, int lastIndex);
+
+    void assign(Curve& source);
+
+    // Sizes the sample arrays once so that edits up to this many points do not allocate
+    void reserve(int controlPoints);
+
+    void addToOverlay(Overlay& overlay);
 
-    bool createShaderProgram();
+    // Capacity of the sample and segment arrays, in bytes
+    long long memoryBytes() const;
 
-    void draw(double deltaTime, Matrix4& lookAt, Matrix4& perspective);
+    // Called by the consumer of the change range once it has picked the changes up
+    void clearDirty();
 
-    void cleanup();
+private:
+    void sampleSegment(int index);
 
+    void markDirty(int first, int last);
 };
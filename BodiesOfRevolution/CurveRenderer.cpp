@@ -0,0 +1,161 @@
+#include "CurveRenderer.h"
+#include "FrameUniforms.h"
+#include "GLState.h"
+#include "Tools.h"
+#include <algorithm>
+
+#define SEGMENT_FLOATS 8
+
+bool CurveRenderer::create()
+{
+    if (!createShaderProgram())
+        return false;
+
+    if (!this->model.create(false))
+        return false;
+
+    // Two control points per attribute, advanced once per instance
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, SEGMENT_FLOATS * sizeof(GLfloat), (const GLvoid*)0);
+    glVertexAttribDivisor(0, 1);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, SEGMENT_FLOATS * sizeof(GLfloat), (const GLvoid*)(4 * sizeof(GLfloat)));
+    glVertexAttribDivisor(1, 1);
+
+    GLState::bindVertexArray(0);
+
+    return true;
+}
+
+void CurveRenderer::update(Curve& curve)
+{
+    int first = 0, last = 0;
+
+    if (curve.resized)
+        last = curve.segments.size();
+    else if (curve.dirtyFirst < curve.dirtyLast)
+    {
+        first = curve.dirtyFirst / RESOLUTION;
+        last = std::min((curve.dirtyLast + RESOLUTION - 1) / RESOLUTION, (int)curve.segments.size());
+    }
+
+    bool resized = curve.resized;
+    curve.clearDirty();
+
+    if (first >= last)
+    {
+        if (resized)
+            this->segmentCount = 0;
+        return;
+    }
+
+    this->staging.resize(curve.segments.size() * SEGMENT_FLOATS);
+
+    for (int i = first; i < last; i++)
+        for (int k = 0; k < 4; k++)
+        {
+            this->staging[i * SEGMENT_FLOATS + 2 * k] = curve.segments[i].points[k].x;
+            this->staging[i * SEGMENT_FLOATS + 2 * k + 1] = curve.segments[i].points[k].y;
+        }
+
+    long long bytes = this->staging.size() * sizeof(GLfloat);
+    if (bytes > this->model.vertexCapacity)
+    {
+        // Grow geometrically and refill, the old storage is orphaned
+        this->model.allocateVertices(bytes + bytes / 2, GL_DYNAMIC_DRAW);
+        first = 0;
+    }
+
+    this->model.updateVertices(first * SEGMENT_FLOATS * sizeof(GLfloat), this->staging.data() + first * SEGMENT_FLOATS,
+        (last - first) * SEGMENT_FLOATS * sizeof(GLfloat));
+
+    this->segmentCount = curve.segments.size();
+}
+
+void CurveRenderer::draw()
+{
+    if (this->segmentCount == 0)
+        return;
+
+    GLState::useProgram(this->shaderProgram);
+    GLState::bindVertexArray(this->model.vao);
+
+    glUniform1f(this->uSamples, this->samples);
+    glUniform3f(this->uColor, 0.0f, 1.0f, 0.0f);
+
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, this->samples + 1, this->segmentCount);
+}
+
+void CurveRenderer::cleanup()
+{
+    if (this->shaderProgram != 0)
+        GLState::deleteProgram(this->shaderProgram);
+
+    this->model.release();
+}
+
+long long CurveRenderer::memoryBytes() const
+{
+    return vectorBytes(this->staging);
+}
+
+bool CurveRenderer::createShaderProgram()
+{
+    this->shaderProgram = 0;
+
+    const GLchar vsh[] =
+        "#version 330\n"
+        ""
+        "layout(location = 0) in vec4 a_p01;"
+        "layout(location = 1) in vec4 a_p23;"
+        ""
+        CAMERA_BLOCK
+        ""
+        "uniform float u_samples;"
+        ""
+        "void main()"
+        "{"
+        "    float t = float(gl_VertexID) / u_samples;"
+        "    float s = 1.0 - t;"
+        ""
+        "    vec2 p = s * s * s * a_p01.xy + 3.0 * s * s * t * a_p01.zw + 3.0 * s * t * t * a_p23.xy + t * t * t * a_p23.zw;"
+        "    gl_Position = u_viewProjection * vec4(p, 0.0, 1.0);"
+        "}"
+        ;
+
+    const GLchar fsh[] =
+        "#version 330\n"
+        ""
+        "uniform vec3 u_color;"
+        ""
+        "layout(location = 0) out vec4 o_color;"
+        ""
+        "void main()"
+        "{"
+        "    o_color = vec4(u_color, 1.0);"
+        "}"
+        ;
+
+    GLuint vertexShader, fragmentShader;
+
+    vertexShader = createShader(vsh, GL_VERTEX_SHADER);
+    fragmentShader = createShader(fsh, GL_FRAGMENT_SHADER);
+
+    if (vertexShader != 0 && fragmentShader != 0)
+        this->shaderProgram = createProgram(vertexShader, fragmentShader);
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    // Compile and link errors are already printed
+    if (this->shaderProgram == 0)
+        return false;
+
+    this->uSamples = glGetUniformLocation(this->shaderProgram, "u_samples");
+    this->uColor = glGetUniformLocation(this->shaderProgram, "u_color");
+
+    FrameUniforms::bind(this->shaderProgram);
+
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include "Curve.h"
+#include "Model.h"
+
+// Default number of line pieces every Bezier segment is drawn with
+#define CURVE_GPU_SAMPLES 64
+
+// Draws the profile from its Bezier control points instead of the flattened polyline. Every
+// segment is one instance of 8 floats, the vertex shader evaluates the cubic at gl_VertexID.
+// Edits upload only the changed segments, the sample count is a uniform.
+class CurveRenderer
+{
+public:
+    GLuint shaderProgram = 0;
+    GLint uSamples, uColor;
+    Model model{ MemorySubsystem::curve };
+
+    int samples = CURVE_GPU_SAMPLES;
+    int segmentCount = 0;
+
+    bool create();
+
+    // Uploads the segments changed since the last call and clears the change range of the curve
+    void update(Curve& curve);
+
+    void draw();
+
+    void cleanup();
+
+    long long memoryBytes() const;
+
+private:
+    // Float copies of the control points, kept between updates
+    std::vector<GLfloat> staging;
+
+    bool createShaderProgram();
+};
@@ -0,0 +1,346 @@
+#include "DistanceField.h"
+#include "Parallel.h"
+#include "Tools.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SDF_SSE
+#endif
+
+#define EDGE_CHUNK 8
+#define NEWTON_ITERATIONS 4
+
+static const float FAR_AWAY = 1.0e18f;
+
+void DistanceField::build(const std::vector<Segment>& segments, Matrix4& model)
+{
+    this->segments = segments;
+
+    this->ax.clear();
+    this->ay.clear();
+    this->dx.clear();
+    this->dy.clear();
+    this->invLength2.clear();
+    this->edgeSegment.clear();
+    this->edgeCount = 0;
+
+    for (int i = 0; i < (int)segments.size(); i++)
+    {
+        Point2D a = segments[i].points[0];
+        for (int k = 1; k <= SDF_SAMPLES; k++)
+        {
+            Point2D b = segments[i].calc((double)k / SDF_SAMPLES);
+            addEdge(a, b, i);
+            a = b;
+        }
+    }
+
+    // End caps from the first and last points down to the axis close the solid
+    if (!segments.empty())
+    {
+        Point2D first = segments.front().points[0];
+        Point2D last = segments.back().points[3];
+        addEdge(Point2D(first.x, 0.0), first, -1);
+        addEdge(last, Point2D(last.x, 0.0), -1);
+    }
+
+    // Padding edges never win the minimum and never cross the inside test ray
+    while (this->ax.size() % EDGE_CHUNK != 0)
+    {
+        this->ax.push_back(FAR_AWAY);
+        this->ay.push_back(FAR_AWAY);
+        this->dx.push_back(0.0f);
+        this->dy.push_back(0.0f);
+        this->invLength2.push_back(0.0f);
+        this->edgeSegment.push_back(-1);
+    }
+
+    // Signed area of the closed profile, the segment along the axis adds nothing
+    double area = 0.0;
+    for (int e = 0; e < this->edgeCount; e++)
+        area += this->ax[e] * this->dy[e] - this->dx[e] * this->ay[e];
+    this->orientation = area < 0.0 ? -1.0 : 1.0;
+
+    int chunkCount = this->ax.size() / EDGE_CHUNK;
+    this->chunkMinX.assign(chunkCount, FAR_AWAY);
+    this->chunkMaxX.assign(chunkCount, -FAR_AWAY);
+    this->chunkMinY.assign(chunkCount, FAR_AWAY);
+    this->chunkMaxY.assign(chunkCount, -FAR_AWAY);
+
+    this->minX = FAR_AWAY;
+    this->maxX = -FAR_AWAY;
+
+    for (int e = 0; e < this->edgeCount; e++)
+    {
+        int c = e / EDGE_CHUNK;
+        float x0 = this->ax[e], x1 = this->ax[e] + this->dx[e];
+        float y0 = this->ay[e], y1 = this->ay[e] + this->dy[e];
+
+        this->chunkMinX[c] = std::min(this->chunkMinX[c], std::min(x0, x1));
+        this->chunkMaxX[c] = std::max(this->chunkMaxX[c], std::max(x0, x1));
+        this->chunkMinY[c] = std::min(this->chunkMinY[c], std::min(y0, y1));
+        this->chunkMaxY[c] = std::max(this->chunkMaxY[c], std::max(y0, y1));
+
+        this->minX = std::min(this->minX, (double)std::min(x0, x1));
+        this->maxX = std::max(this->maxX, (double)std::max(x0, x1));
+    }
+
+    int binCount = this->edgeCount / 4 + 1;
+    this->binWidth = (this->maxX - this->minX) / binCount;
+    if (IS_ZERO(this->binWidth))
+        this->binWidth = 1.0;
+
+    this->bins.assign(binCount, std::vector<int>());
+    for (int e = 0; e < this->edgeCount; e++)
+    {
+        double x0 = std::min(this->ax[e], this->ax[e] + this->dx[e]);
+        double x1 = std::max(this->ax[e], this->ax[e] + this->dx[e]);
+        int b0 = std::max(0, (int)((x0 - this->minX) / this->binWidth));
+        int b1 = std::min(binCount - 1, (int)((x1 - this->minX) / this->binWidth));
+        for (int b = b0; b <= b1; b++)
+            this->bins[b].push_back(e);
+    }
+
+    double m[16];
+    for (int i = 0; i < 16; i++)
+        m[i] = model.elements[i];
+
+    // Uniform scale is assumed: the length of a transformed unit vector
+    this->scale = sqrt(m[0] * m[0] + m[4] * m[4] + m[8] * m[8]);
+
+    invertAffine(m, this->inverse);
+
+    for (int i = 0; i < 16; i++)
+        this->inverseBatch.m[i] = (float)this->inverse[i];
+}
+
+float DistanceField::distance(Vector3 point) const
+{
+    double p[3] = { point[0], point[1], point[2] }, o[3];
+    transformPoint(this->inverse, p, o);
+
+    return profileDistance(o[0], sqrt(o[1] * o[1] + o[2] * o[2])) * this->scale;
+}
+
+void DistanceField::distance(const float* points, float* distances, int count) const
+{
+    parallelFor(count, 4096, [&](int begin, int end)
+    {
+        const int block = 256;
+        float o[3 * block];
+
+        for (int first = begin; first < end; first += block)
+        {
+            int n = std::min(block, end - first);
+            transformPoints(this->inverseBatch, points + 3 * first, o, n);
+
+            for (int i = 0; i < n; i++)
+            {
+                double x = o[3 * i], y = o[3 * i + 1], z = o[3 * i + 2];
+                distances[first + i] = profileDistance(x, sqrt(y * y + z * z)) * this->scale;
+            }
+        }
+    });
+}
+
+double DistanceField::profileDistance(double x, double r) const
+{
+    if (this->edgeCount == 0)
+        return FAR_AWAY;
+
+    float qx = x, qy = r;
+    float best = FAR_AWAY;
+    int bestEdge = -1;
+
+    int chunkCount = this->chunkMinX.size();
+
+    // Start from a chunk next to the query along the axis so that culling kicks in early
+    int seed = 0;
+    if (x >= this->maxX)
+        seed = chunkCount - 1;
+    else if (x > this->minX)
+    {
+        const std::vector<int>& bin = this->bins[std::min((int)this->bins.size() - 1, (int)((x - this->minX) / this->binWidth))];
+        if (!bin.empty())
+            seed = bin[0] / EDGE_CHUNK;
+    }
+
+    for (int i = -1; i < chunkCount; i++)
+    {
+        int c = i < 0 ? seed : i;
+        if (i == seed)
+            continue;
+
+        // Skip chunks whose bounds are farther than the closest edge found so far
+        float bx = std::max(std::max(this->chunkMinX[c] - qx, qx - this->chunkMaxX[c]), 0.0f);
+        float by = std::max(std::max(this->chunkMinY[c] - qy, qy - this->chunkMaxY[c]), 0.0f);
+        if (bx * bx + by * by >= best)
+            continue;
+
+        int base = c * EDGE_CHUNK;
+        float d2[EDGE_CHUNK];
+
+#ifdef SDF_SSE
+        __m128 vqx = _mm_set1_ps(qx), vqy = _mm_set1_ps(qy);
+        __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+
+        for (int k = 0; k < EDGE_CHUNK; k += 4)
+        {
+            __m128 vax = _mm_loadu_ps(&this->ax[base + k]);
+            __m128 vay = _mm_loadu_ps(&this->ay[base + k]);
+            __m128 vdx = _mm_loadu_ps(&this->dx[base + k]);
+            __m128 vdy = _mm_loadu_ps(&this->dy[base + k]);
+            __m128 vil = _mm_loadu_ps(&this->invLength2[base + k]);
+
+            __m128 px = _mm_sub_ps(vqx, vax);
+            __m128 py = _mm_sub_ps(vqy, vay);
+
+            // Projection parameter on the edge, clamped to its end points
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(px, vdx), _mm_mul_ps(py, vdy)), vil);
+            t = _mm_min_ps(_mm_max_ps(t, zero), one);
+
+            __m128 ex = _mm_sub_ps(px, _mm_mul_ps(t, vdx));
+            __m128 ey = _mm_sub_ps(py, _mm_mul_ps(t, vdy));
+
+            _mm_storeu_ps(&d2[k], _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+        }
+#else
+        for (int k = 0; k < EDGE_CHUNK; k++)
+        {
+            int e = base + k;
+            float px = qx - this->ax[e], py = qy - this->ay[e];
+            float t = (px * this->dx[e] + py * this->dy[e]) * this->invLength2[e];
+            t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+            float ex = px - t * this->dx[e], ey = py - t * this->dy[e];
+            d2[k] = ex * ex + ey * ey;
+        }
+#endif
+
+        for (int k = 0; k < EDGE_CHUNK; k++)
+            if (d2[k] < best)
+            {
+                best = d2[k];
+                bestEdge = base + k;
+            }
+    }
+
+    // Nothing beats FAR_AWAY for a query that is not a number
+    if (bestEdge < 0)
+        return FAR_AWAY;
+
+    // The polyline is a chord of the curve and may pass closer to the query than the curve does.
+    // The distance to a Bezier edge comes from Newton iterations on the cubic, started on the closest
+    // edge and on its neighbours, which may hold the closest point of the curve. Only the end caps are straight.
+    // Around the closed profile the first cap comes before edge 0 and the last cap after the last curve edge.
+    int curveEdges = this->edgeCount - 2;
+    int position = bestEdge == curveEdges ? 0 : (bestEdge == curveEdges + 1 ? curveEdges + 1 : bestEdge + 1);
+
+    double result = FAR_AWAY, side = 0.0;
+    bool curveSide = false;
+
+    for (int p = std::max(0, position - 1); p <= std::min(curveEdges + 1, position + 1); p++)
+    {
+        int e = p == 0 ? curveEdges : (p == curveEdges + 1 ? curveEdges + 1 : p - 1);
+
+        double px = x - this->ax[e], py = r - this->ay[e];
+        double t = (px * this->dx[e] + py * this->dy[e]) * this->invLength2[e];
+        t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+
+        int segment = this->edgeSegment[e];
+        if (segment >= 0)
+        {
+            double u = (e - segment * SDF_SAMPLES + t) / SDF_SAMPLES, edgeSide;
+            double d = refine(segment, u, x, r, edgeSide);
+            if (d < result)
+            {
+                result = d;
+                side = edgeSide;
+
+                // The corners with the end caps have no tangent, the polygon decides there
+                curveSide = !(segment == 0 && u <= 0.0) && !(segment == (int)this->segments.size() - 1 && u >= 1.0);
+            }
+        }
+        else
+        {
+            double d = hypot(px - t * this->dx[e], py - t * this->dy[e]);
+            if (d < result)
+            {
+                result = d;
+                curveSide = false;
+            }
+        }
+    }
+
+    // Between a chord and the curve the polygon would give the wrong sign, the side of the
+    // closest curve point keeps the field continuous across the surface
+    bool isInside = curveSide ? side * this->orientation > 0.0 : inside(x, r);
+    return isInside ? -result : result;
+}
+
+void DistanceField::addEdge(const Point2D& a, const Point2D& b, int segment)
+{
+    double ex = b.x - a.x, ey = b.y - a.y;
+    double length2 = ex * ex + ey * ey;
+
+    this->ax.push_back(a.x);
+    this->ay.push_back(a.y);
+    this->dx.push_back(ex);
+    this->dy.push_back(ey);
+    this->invLength2.push_back(IS_ZERO(length2) ? 0.0f : 1.0 / length2);
+    this->edgeSegment.push_back(segment);
+    this->edgeCount++;
+}
+
+bool DistanceField::inside(double x, double r) const
+{
+    if (x < this->minX || x > this->maxX)
+        return false;
+
+    int b = std::min((int)this->bins.size() - 1, (int)((x - this->minX) / this->binWidth));
+
+    // Even-odd rule with a ray from the query point away from the axis
+    bool result = false;
+    for (int e : this->bins[b])
+    {
+        double x0 = this->ax[e], x1 = this->ax[e] + this->dx[e];
+        if ((x0 > x) == (x1 > x))
+            continue;
+
+        double y = this->ay[e] + (x - x0) / this->dx[e] * this->dy[e];
+        if (y > r)
+            result = !result;
+    }
+
+    return result;
+}
+
+double DistanceField::refine(int segment, double& u, double x, double r, double& side) const
+{
+    const Segment& s = this->segments[segment];
+
+    // Second derivative of the cubic is linear in u
+    Point2D a = s.points[2] - s.points[1] * 2.0 + s.points[0];
+    Point2D b = s.points[3] - s.points[2] * 2.0 + s.points[1];
+
+    // Newton iterations on f(u) = (B(u) - q) . B'(u)
+    for (int i = 0; i < NEWTON_ITERATIONS; i++)
+    {
+        Point2D p = s.calc(u), d = s.derivative(u);
+        Point2D e = p - Point2D(x, r);
+        Point2D dd = (a * (1.0 - u) + b * u) * 6.0;
+
+        double f = e.x * d.x + e.y * d.y;
+        double df = d.x * d.x + d.y * d.y + e.x * dd.x + e.y * dd.y;
+        if (IS_ZERO(df))
+            break;
+
+        u -= f / df;
+        u = u < 0.0 ? 0.0 : (u > 1.0 ? 1.0 : u);
+    }
+
+    Point2D e = s.calc(u) - Point2D(x, r), d = s.derivative(u);
+    side = e.x * d.y - e.y * d.x;
+    return sqrt(e.x * e.x + e.y * e.y);
+}
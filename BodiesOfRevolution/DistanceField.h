@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include "tbezier.h"
+#include "Matrix.h"
+#include "SimdMath.h"
+
+// Polyline samples per Bezier segment used to bracket the closest point before refinement
+#define SDF_SAMPLES 16
+
+// Signed distance to a solid of revolution, evaluated in profile space: a point maps to
+// (axial, radial) coordinates and is measured against the profile closed by its end caps.
+// Negative values are inside the body.
+class DistanceField
+{
+public:
+    void build(const std::vector<Segment>& segments, Matrix4& model);
+
+    // World space queries, the result is in world units
+    float distance(Vector3 point) const;
+
+    void distance(const float* points, float* distances, int count) const;
+
+    // Profile space query, the result is in profile units
+    double profileDistance(double x, double r) const;
+
+private:
+    std::vector<Segment> segments;
+
+    // Edges of the closed profile polyline in SoA layout, padded to a multiple of EDGE_CHUNK
+    std::vector<float> ax, ay, dx, dy, invLength2;
+    std::vector<int> edgeSegment; // Bezier segment of the edge, -1 for the end caps
+    int edgeCount = 0;
+
+    // Bounds of every chunk of EDGE_CHUNK consecutive edges for distance culling
+    std::vector<float> chunkMinX, chunkMaxX, chunkMinY, chunkMaxY;
+
+    // Edges overlapping every axial bin, for the inside test
+    std::vector<std::vector<int>> bins;
+    double minX = 0.0, maxX = 0.0, binWidth = 1.0;
+
+    double inverse[16];
+    Mat4f inverseBatch; // float copy of inverse for the batch query
+    double scale = 1.0;
+
+    // 1 when the closed profile runs counterclockwise, -1 otherwise
+    double orientation = 1.0;
+
+    void addEdge(const Point2D& a, const Point2D& b, int segment);
+
+    bool inside(double x, double r) const;
+
+    // Distance to the closest point of the segment near parameter u, which is updated to it.
+    // side is positive when the query lies left of the curve.
+    double refine(int segment, double& u, double x, double r, double& side) const;
+};
@@ -0,0 +1,369 @@
+#include "EditWorker.h"
+#include "AllocationCounter.h"
+#include "MemoryRegistry.h"
+#include "TessellationError.h"
+#include "GlbExport.h"
+#include <GLFW/glfw3.h>
+#include <assert.h>
+#include <chrono>
+#include <iostream>
+
+void EditWorker::start()
+{
+    // Scratch storage is sized once up front, later growth is geometric
+    this->profile.reserve(EDIT_RESERVE_POINTS);
+    this->curve.reserve(EDIT_RESERVE_POINTS);
+    this->resultCurve.reserve(EDIT_RESERVE_POINTS);
+
+    this->running = true;
+    this->thread = std::thread(&EditWorker::run, this);
+}
+
+void EditWorker::stop()
+{
+    if (!this->running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->wakeMutex);
+        this->running = false;
+    }
+    this->wake.notify_one();
+    this->thread.join();
+}
+
+void EditWorker::push(const EditCommand& command)
+{
+    // The queue only fills up if the worker falls far behind, wait for it in that case
+    while (!this->commands.push(command))
+        std::this_thread::yield();
+    this->pushed++;
+
+    {
+        std::lock_guard<std::mutex> lock(this->wakeMutex);
+    }
+    this->wake.notify_one();
+}
+
+void EditWorker::wait()
+{
+    while (this->running && this->applied < this->pushed)
+        std::this_thread::yield();
+}
+
+bool EditWorker::receiveProfile(std::vector<Point2D>& profile, int& restores)
+{
+    std::lock_guard<std::mutex> lock(this->resultMutex);
+
+    restores = this->restores;
+
+    if (!this->profileReady)
+        return false;
+
+    profile = this->resultProfile;
+    this->profileReady = false;
+    return true;
+}
+
+bool EditWorker::receiveSimplified(RevolutionMesh& mesh)
+{
+    std::lock_guard<std::mutex> lock(this->resultMutex);
+
+    if (!this->simplifiedReady)
+        return false;
+
+    std::swap(mesh, this->resultSimplified);
+    this->simplifiedReady = false;
+    return true;
+}
+
+bool EditWorker::receive(Curve& curve, RevolutionMesh& mesh)
+{
+    std::lock_guard<std::mutex> lock(this->resultMutex);
+
+    curve.assign(this->resultCurve);
+
+    if (!this->meshReady)
+        return false;
+
+    std::swap(mesh, this->resultMesh);
+    this->meshReady = false;
+    return true;
+}
+
+void EditWorker::run()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->wakeMutex);
+            this->wake.wait(lock, [this]() { return !this->running || !this->commands.empty(); });
+
+            if (!this->running)
+                return;
+        }
+
+        apply();
+
+        // Wake the render thread in case it is waiting for events
+        glfwPostEmptyEvent();
+    }
+}
+
+void EditWorker::apply()
+{
+    AllocationScope allocationScope;
+
+    // Storage the batch writes into, a batch that grows none of it must not allocate
+    long long storageBytes = vectorBytes(this->profile) + this->curve.memoryBytes();
+    bool grew = false;
+
+    bool rebuild = false, buildBody = false, checkpointed = false, restored = false, measure = false, simplify = false;
+    int firstMoved = -1, lastMoved = -1, revolutions = 0, count = 0, restoreCommands = 0, measureRevolutions = 0, simplifyRatio = 0;
+    int exportChoice = -1;
+    double tolerance = 0.0, simplifyError = 0.0;
+
+    // Everything queued so far is applied before the curve is recomputed once
+    EditCommand command;
+    while (this->commands.pop(command))
+    {
+        count++;
+
+        // Edits after a restore in the same batch need the full rebuild
+        bool edit = command.type == EditCommandType::add || command.type == EditCommandType::pop || command.type == EditCommandType::move;
+        if (edit)
+        {
+            this->stateId = 0;
+            if (restored)
+            {
+                restored = false;
+                rebuild = true;
+            }
+        }
+
+        const ProfileState* state = NULL;
+
+        switch (command.type)
+        {
+        case EditCommandType::add:
+            this->profile.push_back(Point2D(command.x, command.y));
+            rebuild = true;
+            break;
+        case EditCommandType::pop:
+            if (!this->profile.empty())
+                this->profile.pop_back();
+            rebuild = true;
+            break;
+        case EditCommandType::move:
+            if (command.index < 0 || command.index >= (int)this->profile.size())
+                break;
+            this->profile[command.index] = Point2D(command.x, command.y);
+            firstMoved = firstMoved < 0 || command.index < firstMoved ? command.index : firstMoved;
+            lastMoved = command.index > lastMoved ? command.index : lastMoved;
+            break;
+        case EditCommandType::buildBody:
+            buildBody = true;
+            revolutions = this->bodyRevolutions = command.index;
+            break;
+        case EditCommandType::checkpoint:
+            if (this->history.checkpoint(this->profile))
+                checkpointed = true;
+            this->stateId = this->history.current().id;
+            break;
+        case EditCommandType::undo:
+        case EditCommandType::redo:
+            restoreCommands++;
+            state = command.type == EditCommandType::undo ? this->history.undo() : this->history.redo();
+            if (state == NULL)
+                break;
+            state->copyTo(this->profile);
+            this->stateId = state->id;
+            restored = true;
+            rebuild = false;
+            firstMoved = lastMoved = -1;
+            break;
+        case EditCommandType::measureTessellation:
+            measure = true;
+            measureRevolutions = command.index;
+            tolerance = command.x;
+            break;
+        case EditCommandType::simplifyBody:
+            simplify = true;
+            simplifyRatio = command.index;
+            simplifyError = command.x;
+            break;
+        case EditCommandType::exportBody:
+            exportChoice = command.index;
+            break;
+        }
+    }
+
+    if (restored)
+    {
+        // Stepping through the history reuses the curve computed for the state before
+        std::shared_ptr<const Curve> cached = this->cache.findCurve(this->stateId);
+        if (cached != NULL)
+        {
+            this->curve = *cached;
+            this->curve.resized = this->curve.dirty = true;
+            this->cacheHits++;
+        }
+        else
+            rebuild = true;
+
+        if (this->bodyRevolutions > 0)
+        {
+            buildBody = true;
+            revolutions = this->bodyRevolutions;
+        }
+    }
+
+    if (rebuild)
+        this->curve.calculateCurvePoints(this->profile);
+    else if (firstMoved >= 0)
+        this->curve.updateCurvePoints(this->profile, firstMoved, lastMoved);
+
+    if (rebuild || firstMoved >= 0)
+        this->curveUpdates++;
+
+    grew = vectorBytes(this->profile) + this->curve.memoryBytes() > storageBytes;
+
+    if (this->stateId != 0 && (rebuild || checkpointed))
+        this->cache.putCurve(this->stateId, this->curve);
+
+    if (buildBody)
+    {
+        std::shared_ptr<const RevolutionMesh> cached = this->stateId != 0 ? this->cache.findMesh(this->stateId, revolutions) : NULL;
+        if (cached != NULL)
+        {
+            this->mesh = *cached;
+            this->cacheHits++;
+        }
+        else
+        {
+            long long meshBytes = this->mesh.memoryBytes();
+
+            auto start = std::chrono::steady_clock::now();
+            buildBody = this->mesh.build(this->curve.points2D, this->curve.tangents2D, revolutions);
+            grew = grew || this->mesh.memoryBytes() > meshBytes;
+            this->meshMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            this->meshBuilds++;
+
+            if (buildBody && this->stateId != 0)
+                this->cache.putMesh(this->stateId, revolutions, this->mesh);
+        }
+    }
+
+    // Simplifies the body as it stands after the batch, like the mesh published with it
+    if (simplify)
+        simplify = simplifyBody(simplifyRatio, simplifyError);
+
+    if (checkpointed || restoreCommands > 0)
+        this->historyBytes = this->history.memoryBytes() + this->cache.memoryBytes();
+
+    {
+        std::lock_guard<std::mutex> lock(this->resultMutex);
+
+        long long resultBytes = this->resultCurve.memoryBytes();
+        this->resultCurve.assign(this->curve);
+        grew = grew || this->resultCurve.memoryBytes() > resultBytes;
+
+        if (buildBody)
+        {
+            std::swap(this->mesh, this->resultMesh);
+            this->meshReady = true;
+            this->simplifiedReady = false;
+        }
+
+        if (simplify)
+        {
+            this->resultSimplified = this->simplified;
+            this->simplifiedReady = true;
+        }
+
+        if (restoreCommands > 0)
+        {
+            this->resultProfile = this->profile;
+            this->profileReady = true;
+            this->restores += restoreCommands;
+        }
+
+        MemoryRegistry::setCpuBytes(MemorySubsystem::editWorker, vectorBytes(this->profile) + this->curve.memoryBytes()
+            + this->mesh.memoryBytes() + this->resultCurve.memoryBytes() + this->resultMesh.memoryBytes()
+            + this->remeshed.memoryBytes() + this->simplified.memoryBytes() + this->resultSimplified.memoryBytes());
+        MemoryRegistry::setCpuBytes(MemorySubsystem::history, this->historyBytes);
+    }
+
+    // Measuring meshes the profile many times and exporting encodes the whole body, the results above
+    // are published first
+    if (measure)
+        reportTessellation(measureRevolutions, tolerance);
+
+    if (exportChoice >= 0)
+        exportBody(exportChoice == 1);
+
+    // Edits, meshing and publishing rewrite storage that is already large enough once it has grown
+    // to the profile and revolutions in use. History, cached states, measuring, simplifying and exporting
+    // allocate by design.
+    bool allocates = grew || checkpointed || restoreCommands > 0 || measure || simplify || exportChoice >= 0 || this->stateId != 0;
+    if (!allocates && allocationScope.allocations() > 0)
+        this->allocatingBatches++;
+
+#ifdef BOR_COUNT_ALLOCATIONS
+    if (allocationScope.allocations() > 0)
+        std::cout << "Edit: " << allocationScope.allocations() << " allocations, " << allocationScope.bytes() << " bytes" << std::endl;
+
+    assert(allocates || allocationScope.allocations() == 0);
+#endif
+
+    this->applied += count;
+}
+
+void EditWorker::reportTessellation(int revolutions, double tolerance)
+{
+    if (this->curve.segments.empty())
+        return;
+
+    TessellationReport report;
+    if (measureTessellation(this->curve.segments, RESOLUTION, revolutions, report))
+        report.print();
+
+    TessellationReport best;
+    bool found = chooseTessellation(this->curve.segments, tolerance, { 8, 16, 32 }, { 32, 64, 128, 256 }, best);
+    std::cout << (found ? "Cheapest tessellation within " : "No tessellation within ") << tolerance << ": "
+        << best.samplesPerSegment << " samples x " << best.revolutions << " revolutions, "
+        << best.triangles << " triangles, Hausdorff " << best.hausdorff() << std::endl;
+}
+
+bool EditWorker::simplifyBody(int ratio, double errorBound)
+{
+    if (this->bodyRevolutions <= 0 || ratio <= 0)
+        return false;
+
+    if (!this->remeshed.build(this->curve.points2D, this->curve.tangents2D, this->bodyRevolutions))
+        return false;
+
+    MeshSimplifier& s = this->simplifier;
+    if (!s.simplify(this->remeshed, this->simplified, this->remeshed.triangleCount() / ratio, errorBound))
+        return false;
+
+    std::cout << "Simplified " << s.inputTriangles << " -> " << s.outputTriangles << " triangles, "
+        << s.collapses << " collapses, max error " << s.maxError << " in " << s.milliseconds << " ms" << std::endl;
+    return true;
+}
+
+void EditWorker::exportBody(bool simplified)
+{
+    if (this->bodyRevolutions <= 0)
+        return;
+
+    if (!simplified && !this->remeshed.build(this->curve.points2D, this->curve.tangents2D, this->bodyRevolutions))
+        return;
+
+    GlbExportOptions options;
+    GlbExportReport report;
+    if (exportGlb(simplified ? this->simplified : this->remeshed, EDIT_EXPORT_PATH, options, report))
+        std::cout << "Exported " << EDIT_EXPORT_PATH << ": " << report.fileBytes << " bytes (" << report.rawBytes << " raw), "
+            << report.indexBits << "-bit indices, encoded in " << report.encodeMilliseconds << " ms, written in "
+            << report.writeMilliseconds << " ms" << std::endl;
+}
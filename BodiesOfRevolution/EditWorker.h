@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SpscQueue.h"
+#include "Curve.h"
+#include "RevolutionMesh.h"
+#include "ProfileHistory.h"
+#include "MeshSimplifier.h"
+
+// Control points the edit path is sized for up front
+#define EDIT_RESERVE_POINTS 256
+
+// File written by exportBody
+#define EDIT_EXPORT_PATH "body.glb"
+
+enum class EditCommandType
+{
+    add,
+    pop,
+    move,
+    buildBody,
+    checkpoint, // records the profile as an undo step
+    undo,
+    redo,
+    measureTessellation, // prints the tessellation error of the body and the cheapest setting within tolerance x
+    simplifyBody, // reduces the body to 1 / index of its triangles within the error bound x
+    exportBody // writes the body, or its last simplified mesh when index is 1, as binary glTF
+};
+
+class EditCommand
+{
+public:
+    EditCommandType type;
+    int index;      // moved point, revolutions for buildBody and measureTessellation, the ratio for simplifyBody
+                    // or the mesh choice for exportBody
+    double x, y;
+};
+
+// Applies profile edits and meshes bodies off the render thread. Input callbacks push commands,
+// the render thread picks up the finished curve and mesh once per frame with receive().
+// The worker only uses the CPU side of its Curve objects.
+class EditWorker
+{
+public:
+    void start();
+
+    void stop();
+
+    void push(const EditCommand& command);
+
+    // Brings curve up to date and returns true when a new body mesh was handed over
+    bool receive(Curve& curve, RevolutionMesh& mesh);
+
+    // Blocks until every pushed command has been applied, used by deterministic replays
+    void wait();
+
+    // Returns true with the simplified body once simplifyBody was applied. A body meshed after the
+    // request replaces a result that was not picked up yet, so it always matches the last received body.
+    bool receiveSimplified(RevolutionMesh& mesh);
+
+    // Returns true with the restored profile after undo or redo, restores counts the undo and
+    // redo commands applied so far
+    bool receiveProfile(std::vector<Point2D>& profile, int& restores);
+
+    // Statistics, read after stop()
+    int curveUpdates = 0;
+    int meshBuilds = 0;
+    double meshMilliseconds = 0.0;
+    int cacheHits = 0;
+
+    // Batches that allocated although they grew no storage and touched no history, see apply()
+    int allocatingBatches = 0;
+
+private:
+    SpscQueue<EditCommand, 4096> commands;
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    std::atomic<int> pushed{ 0 };
+    std::atomic<int> applied{ 0 };
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+
+    // Worker side state
+    std::vector<Point2D> profile;
+    Curve curve;
+    RevolutionMesh mesh;
+
+    ProfileHistory history;
+    GeometryCache cache;
+
+    // The body meshed again from the curve for simplifying and exporting, it never holds the published
+    // mesh. The last simplified mesh is kept for exporting it as shown.
+    MeshSimplifier simplifier;
+    RevolutionMesh remeshed;
+    RevolutionMesh simplified;
+
+    // History state the profile equals, 0 after edits that are not recorded yet
+    unsigned long long stateId = 0;
+
+    // Revolutions of the body once it was built, restored states are meshed with them
+    int bodyRevolutions = 0;
+
+    long long historyBytes = 0;
+
+    // Results published to the render thread, guarded by resultMutex
+    std::mutex resultMutex;
+    Curve resultCurve;
+    RevolutionMesh resultMesh;
+    bool meshReady = false;
+    std::vector<Point2D> resultProfile;
+    bool profileReady = false;
+    int restores = 0;
+    RevolutionMesh resultSimplified;
+    bool simplifiedReady = false;
+
+    void run();
+
+    void apply();
+
+    void reportTessellation(int revolutions, double tolerance);
+
+    bool simplifyBody(int ratio, double errorBound);
+
+    void exportBody(bool simplified);
+};
@@ -0,0 +1,50 @@
+#include "FrameUniforms.h"
+#include "MemoryRegistry.h"
+#include "GLState.h"
+#include <string.h>
+
+bool FrameUniforms::create()
+{
+    glGenBuffers(1, &this->ubo);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, this->ubo);
+    glBufferData(GL_UNIFORM_BUFFER, 3 * 16 * sizeof(GLfloat), NULL, GL_DYNAMIC_DRAW);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, this->ubo);
+
+    MemoryRegistry::addGpuBytes(MemorySubsystem::uniforms, 3 * 16 * sizeof(GLfloat));
+
+    return this->ubo != 0;
+}
+
+void FrameUniforms::update(const Mat4f& view, const Mat4f& projection)
+{
+    Mat4f viewProjection = projection * view;
+
+    GLfloat data[3 * 16];
+    memcpy(data, view.m, 16 * sizeof(GLfloat));
+    memcpy(data + 16, projection.m, 16 * sizeof(GLfloat));
+    memcpy(data + 32, viewProjection.m, 16 * sizeof(GLfloat));
+
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, this->ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), data);
+}
+
+void FrameUniforms::bind(GLuint program)
+{
+    if (program == 0)
+        return;
+
+    GLuint index = glGetUniformBlockIndex(program, "Camera");
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, CAMERA_BLOCK_BINDING);
+}
+
+void FrameUniforms::cleanup()
+{
+    if (this->ubo != 0)
+    {
+        GLState::deleteBuffer(this->ubo);
+        MemoryRegistry::addGpuBytes(MemorySubsystem::uniforms, -3 * 16 * (long long)sizeof(GLfloat));
+        this->ubo = 0;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <GL/glew.h>
+#include "SimdMath.h"
+
+#define CAMERA_BLOCK_BINDING 0
+
+// std140 declaration shared by all programs, matrices are stored row-major like Mat4f::m
+#define CAMERA_BLOCK \
+    "layout(std140, row_major) uniform Camera" \
+    "{" \
+    "    mat4 u_view;" \
+    "    mat4 u_projection;" \
+    "    mat4 u_viewProjection;" \
+    "};"
+
+// Uniform buffer with the camera matrices, uploaded once per frame and shared by all programs.
+class FrameUniforms
+{
+public:
+    GLuint ubo = 0;
+
+    bool create();
+
+    void update(const Mat4f& view, const Mat4f& projection);
+
+    static void bind(GLuint program);
+
+    void cleanup();
+};
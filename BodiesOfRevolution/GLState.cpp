@@ -0,0 +1,132 @@
+#include "GLState.h"
+
+// Cached values are unknown until the first bind
+static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+enum BufferTarget
+{
+    ARRAY_TARGET,
+    ELEMENT_TARGET,
+    UNIFORM_TARGET,
+    TARGET_COUNT
+};
+
+static GLuint g_program = UNKNOWN;
+static GLuint g_vao = UNKNOWN;
+static GLuint g_buffers[TARGET_COUNT] = { UNKNOWN, UNKNOWN, UNKNOWN };
+
+static GLStateStats g_frame, g_lastFrame, g_total;
+
+static int targetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:
+        return ARRAY_TARGET;
+    case GL_ELEMENT_ARRAY_BUFFER:
+        return ELEMENT_TARGET;
+    case GL_UNIFORM_BUFFER:
+        return UNIFORM_TARGET;
+    default:
+        return -1;
+    }
+}
+
+// Returns true when the call has to be issued and updates the cached value
+static bool change(GLuint& cached, GLuint value)
+{
+    if (cached == value)
+    {
+        g_frame.elided++;
+        return false;
+    }
+
+    cached = value;
+    g_frame.issued++;
+    return true;
+}
+
+void GLState::useProgram(GLuint program)
+{
+    if (change(g_program, program))
+        glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao)
+{
+    if (change(g_vao, vao))
+    {
+        glBindVertexArray(vao);
+        g_buffers[ELEMENT_TARGET] = UNKNOWN;
+    }
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    int index = targetIndex(target);
+    if (index < 0)
+    {
+        g_frame.issued++;
+        glBindBuffer(target, buffer);
+    }
+    else if (change(g_buffers[index], buffer))
+        glBindBuffer(target, buffer);
+}
+
+void GLState::deleteProgram(GLuint program)
+{
+    // A current program stays in use until another one is installed, so the cache is forgotten
+    if (g_program == program)
+        g_program = UNKNOWN;
+
+    glDeleteProgram(program);
+}
+
+void GLState::deleteVertexArray(GLuint vao)
+{
+    if (g_vao == vao)
+    {
+        g_vao = 0;
+        g_buffers[ELEMENT_TARGET] = UNKNOWN;
+    }
+
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GLState::deleteBuffer(GLuint buffer)
+{
+    for (GLuint& cached : g_buffers)
+        if (cached == buffer)
+            cached = 0;
+
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLState::invalidate()
+{
+    g_program = g_vao = UNKNOWN;
+    for (GLuint& cached : g_buffers)
+        cached = UNKNOWN;
+}
+
+void GLState::beginFrame()
+{
+    g_total.issued += g_frame.issued;
+    g_total.elided += g_frame.elided;
+
+    g_lastFrame = g_frame;
+    g_frame = GLStateStats();
+}
+
+GLStateStats GLState::lastFrame()
+{
+    return g_lastFrame;
+}
+
+GLStateStats GLState::total()
+{
+    GLStateStats result = g_total;
+    result.issued += g_frame.issued;
+    result.elided += g_frame.elided;
+    return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <GL/glew.h>
+
+class GLStateStats
+{
+public:
+    long long issued = 0;
+    long long elided = 0;
+};
+
+// Shadow copy of the program, vertex array and buffer bindings. All binds go through here so
+// that calls which would not change the current state never reach the driver. Render thread only.
+// The element array buffer binding is vertex array state, binding a vertex array forgets it.
+class GLState
+{
+public:
+    static void useProgram(GLuint program);
+
+    static void bindVertexArray(GLuint vao);
+
+    // Array, element array and uniform buffers are cached, other targets always go through
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    // Deleting a bound object resets its binding to 0, like GL does
+    static void deleteProgram(GLuint program);
+
+    static void deleteVertexArray(GLuint vao);
+
+    static void deleteBuffer(GLuint buffer);
+
+    // Forgets everything, for state changed behind the cache's back
+    static void invalidate();
+
+    // Closes the counters of the previous frame
+    static void beginFrame();
+
+    static GLStateStats lastFrame();
+
+    static GLStateStats total();
+};
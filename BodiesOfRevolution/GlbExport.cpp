@@ -0,0 +1,356 @@
+#include "GlbExport.h"
+#include "MeshCodec.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <sstream>
+#include <string.h>
+
+#define GLB_MAGIC 0x46546C67
+#define GLB_CHUNK_JSON 0x4E4F534A
+#define GLB_CHUNK_BIN 0x004E4942
+
+#define GLTF_BYTE 5120
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+
+#define GLTF_ARRAY_BUFFER 34962
+#define GLTF_ELEMENT_ARRAY_BUFFER 34963
+
+// Vertices per chunk when quantizing
+#define GLB_VERTEX_CHUNK 16384
+
+class GlbBufferView
+{
+public:
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> encoded;
+
+    int count = 0;
+    int stride = 0;
+    bool indices = false;
+    const char* filter = NULL;
+
+    long long offset = 0;
+    long long fallbackOffset = 0;
+};
+
+static int quantizeSnorm(double v, int bits)
+{
+    double scale = (1 << (bits - 1)) - 1;
+    v = std::min(std::max(v, -1.0), 1.0);
+    return (int)(v * scale + (v >= 0.0 ? 0.5 : -0.5));
+}
+
+// Octahedral mapping as read by the OCTAHEDRAL filter of EXT_meshopt_compression: x and y on the
+// folded octahedron, then the value standing for 1
+static void encodeOctahedral(const float* n, signed char* out)
+{
+    double l = fabs(n[0]) + fabs(n[1]) + fabs(n[2]);
+    double x = l > 0.0 ? n[0] / l : 0.0, y = l > 0.0 ? n[1] / l : 0.0;
+
+    if (n[2] < 0.0f)
+    {
+        double fx = (1.0 - fabs(y)) * (x >= 0.0 ? 1.0 : -1.0);
+        double fy = (1.0 - fabs(x)) * (y >= 0.0 ? 1.0 : -1.0);
+        x = fx;
+        y = fy;
+    }
+
+    out[0] = quantizeSnorm(x, 8);
+    out[1] = quantizeSnorm(y, 8);
+    out[2] = 127;
+    out[3] = 0;
+}
+
+static long long align4(long long v)
+{
+    return (v + 3) & ~3LL;
+}
+
+static void buildPositions(const RevolutionMesh& mesh, const GlbExportOptions& options, const double center[3], double scale,
+    GlbBufferView& view)
+{
+    int n = mesh.vertexCount();
+    view.count = n;
+    view.stride = options.quantize ? 4 * sizeof(short) : 3 * sizeof(float);
+    view.data.assign((long long)n * view.stride, 0);
+
+    parallelFor(n, GLB_VERTEX_CHUNK, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const float* v = &mesh.vertices[6 * i];
+            unsigned char* out = &view.data[(long long)i * view.stride];
+
+            if (options.quantize)
+            {
+                // The fourth component only pads the element to 4 bytes
+                short q[4] = { 0, 0, 0, 0 };
+                for (int k = 0; k < 3; k++)
+                    q[k] = quantizeSnorm((v[k] - center[k]) / scale, 16);
+                memcpy(out, q, sizeof(q));
+            }
+            else
+                memcpy(out, v, 3 * sizeof(float));
+        }
+    });
+}
+
+static void buildNormals(const RevolutionMesh& mesh, const GlbExportOptions& options, GlbBufferView& view)
+{
+    int n = mesh.vertexCount();
+    view.count = n;
+    view.stride = options.quantize ? 4 : 3 * sizeof(float);
+    view.data.assign((long long)n * view.stride, 0);
+
+    bool octahedral = options.quantize && options.compress;
+    if (octahedral)
+        view.filter = "OCTAHEDRAL";
+
+    parallelFor(n, GLB_VERTEX_CHUNK, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const float* normal = &mesh.vertices[6 * i + 3];
+            unsigned char* out = &view.data[(long long)i * view.stride];
+
+            if (octahedral)
+                encodeOctahedral(normal, (signed char*)out);
+            else if (options.quantize)
+            {
+                for (int k = 0; k < 3; k++)
+                    out[k] = (unsigned char)quantizeSnorm(normal[k], 8);
+            }
+            else
+                memcpy(out, normal, 3 * sizeof(float));
+        }
+    });
+}
+
+static void buildIndices(const RevolutionMesh& mesh, int indexBits, GlbBufferView& view)
+{
+    int n = mesh.indices.size();
+    view.count = n;
+    view.stride = indexBits / 8;
+    view.indices = true;
+    view.data.resize((long long)n * view.stride);
+
+    if (indexBits == 32)
+        memcpy(view.data.data(), mesh.indices.data(), view.data.size());
+    else
+    {
+        unsigned short* out = (unsigned short*)view.data.data();
+        for (int i = 0; i < n; i++)
+            out[i] = mesh.indices[i];
+    }
+}
+
+static void writeView(std::ostringstream& json, const GlbBufferView& view, bool compress)
+{
+    json << "{\"buffer\":" << (compress ? 1 : 0) << ",\"byteOffset\":" << (compress ? view.fallbackOffset : view.offset)
+        << ",\"byteLength\":" << view.data.size();
+
+    if (!view.indices)
+        json << ",\"byteStride\":" << view.stride;
+    json << ",\"target\":" << (view.indices ? GLTF_ELEMENT_ARRAY_BUFFER : GLTF_ARRAY_BUFFER);
+
+    if (compress)
+    {
+        json << ",\"extensions\":{\"EXT_meshopt_compression\":{\"buffer\":0,\"byteOffset\":" << view.offset
+            << ",\"byteLength\":" << view.encoded.size() << ",\"byteStride\":" << view.stride << ",\"count\":" << view.count
+            << ",\"mode\":\"" << (view.indices ? "INDICES" : "ATTRIBUTES") << "\"";
+        if (view.filter != NULL)
+            json << ",\"filter\":\"" << view.filter << "\"";
+        json << "}}";
+    }
+
+    json << "}";
+}
+
+bool exportGlb(const RevolutionMesh& mesh, const char* path, const GlbExportOptions& options, GlbExportReport& report)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int vertexCount = mesh.vertexCount();
+    if (vertexCount == 0 || mesh.indices.empty())
+        return false;
+
+    // The largest 16-bit value is reserved for primitive restart
+    int indexBits = options.indexBits;
+    if (indexBits != 16 && indexBits != 32)
+        indexBits = vertexCount <= 65535 ? 16 : 32;
+    if (indexBits == 16 && vertexCount > 65535)
+    {
+        std::cout << "The mesh has too many vertices for 16-bit indices, using 32 bits" << std::endl;
+        indexBits = 32;
+    }
+
+    double lo[3] = { 1e300, 1e300, 1e300 }, hi[3] = { -1e300, -1e300, -1e300 };
+    for (int i = 0; i < vertexCount; i++)
+        for (int k = 0; k < 3; k++)
+        {
+            lo[k] = std::min(lo[k], (double)mesh.vertices[6 * i + k]);
+            hi[k] = std::max(hi[k], (double)mesh.vertices[6 * i + k]);
+        }
+
+    // One scale for all axes keeps the normals valid under the node transform
+    double center[3], scale = 0.0;
+    for (int k = 0; k < 3; k++)
+    {
+        center[k] = (lo[k] + hi[k]) / 2;
+        scale = std::max(scale, (hi[k] - lo[k]) / 2);
+    }
+    if (scale <= 0.0)
+        scale = 1.0;
+
+    GlbBufferView views[3];
+
+    parallelFor(3, 1, [&](int begin, int end)
+    {
+        for (int v = begin; v < end; v++)
+        {
+            GlbBufferView& view = views[v];
+
+            if (v == 0)
+                buildPositions(mesh, options, center, scale, view);
+            else if (v == 1)
+                buildNormals(mesh, options, view);
+            else
+                buildIndices(mesh, indexBits, view);
+
+            if (!options.compress)
+                continue;
+
+            if (view.indices)
+                encodeIndexSequence(mesh.indices.data(), mesh.indices.size(), view.encoded);
+            else
+                encodeVertexBuffer(view.data.data(), view.count, view.stride, view.encoded);
+        }
+    });
+
+    // Binary chunk layout, every view starts on 4 bytes
+    long long binSize = 0, fallbackSize = 0;
+    for (GlbBufferView& view : views)
+    {
+        view.offset = binSize;
+        binSize = align4(binSize + (options.compress ? view.encoded.size() : view.data.size()));
+
+        view.fallbackOffset = fallbackSize;
+        fallbackSize = align4(fallbackSize + view.data.size());
+    }
+
+    std::ostringstream json;
+    json << std::setprecision(9);
+
+    json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"BodiesOfRevolution\"}";
+
+    std::string extensions;
+    if (options.quantize)
+        extensions += "\"KHR_mesh_quantization\"";
+    if (options.compress)
+        extensions += std::string(extensions.empty() ? "" : ",") + "\"EXT_meshopt_compression\"";
+    if (!extensions.empty())
+        json << ",\"extensionsUsed\":[" << extensions << "],\"extensionsRequired\":[" << extensions << "]";
+
+    json << ",\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0";
+    if (options.quantize)
+        json << ",\"translation\":[" << center[0] << "," << center[1] << "," << center[2] << "],\"scale\":[" << scale << ","
+            << scale << "," << scale << "]";
+    json << "}]";
+
+    json << ",\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1},\"indices\":2,\"mode\":4}]}]";
+
+    // Position bounds are required, in the stored units
+    json << ",\"accessors\":[{\"bufferView\":0,\"count\":" << vertexCount << ",\"type\":\"VEC3\"";
+    if (options.quantize)
+    {
+        int qlo[3], qhi[3];
+        for (int k = 0; k < 3; k++)
+        {
+            qlo[k] = quantizeSnorm((lo[k] - center[k]) / scale, 16);
+            qhi[k] = quantizeSnorm((hi[k] - center[k]) / scale, 16);
+        }
+        json << ",\"componentType\":" << GLTF_SHORT << ",\"normalized\":true,\"min\":[" << qlo[0] << "," << qlo[1] << "," << qlo[2]
+            << "],\"max\":[" << qhi[0] << "," << qhi[1] << "," << qhi[2] << "]}";
+    }
+    else
+        json << ",\"componentType\":" << GLTF_FLOAT << ",\"min\":[" << (float)lo[0] << "," << (float)lo[1] << "," << (float)lo[2]
+            << "],\"max\":[" << (float)hi[0] << "," << (float)hi[1] << "," << (float)hi[2] << "]}";
+
+    json << ",{\"bufferView\":1,\"count\":" << vertexCount << ",\"type\":\"VEC3\",\"componentType\":"
+        << (options.quantize ? GLTF_BYTE : GLTF_FLOAT) << (options.quantize ? ",\"normalized\":true}" : "}");
+
+    json << ",{\"bufferView\":2,\"count\":" << mesh.indices.size() << ",\"type\":\"SCALAR\",\"componentType\":"
+        << (indexBits == 16 ? GLTF_UNSIGNED_SHORT : GLTF_UNSIGNED_INT) << "}]";
+
+    json << ",\"bufferViews\":[";
+    for (int v = 0; v < 3; v++)
+    {
+        if (v > 0)
+            json << ",";
+        writeView(json, views[v], options.compress);
+    }
+    json << "]";
+
+    // With compression the uncompressed views live in a fallback buffer that is not stored
+    json << ",\"buffers\":[{\"byteLength\":" << binSize << "}";
+    if (options.compress)
+        json << ",{\"byteLength\":" << fallbackSize << ",\"extensions\":{\"EXT_meshopt_compression\":{\"fallback\":true}}}";
+    json << "]}";
+
+    std::string text = json.str();
+
+    auto encoded = std::chrono::steady_clock::now();
+    report.encodeMilliseconds = std::chrono::duration<double, std::milli>(encoded - start).count();
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Cannot write " << path << std::endl;
+        return false;
+    }
+
+    long long jsonSize = align4(text.size());
+    long long total = 12 + 8 + jsonSize + 8 + binSize;
+
+    // Header, the JSON chunk padded with spaces, the binary chunk padded with zeros
+    unsigned int header[3] = { GLB_MAGIC, 2, (unsigned int)total };
+    file.write((const char*)header, sizeof(header));
+
+    unsigned int jsonHeader[2] = { (unsigned int)jsonSize, GLB_CHUNK_JSON };
+    file.write((const char*)jsonHeader, sizeof(jsonHeader));
+    file.write(text.data(), text.size());
+    for (long long i = text.size(); i < jsonSize; i++)
+        file.put(' ');
+
+    unsigned int binHeader[2] = { (unsigned int)binSize, GLB_CHUNK_BIN };
+    file.write((const char*)binHeader, sizeof(binHeader));
+    for (const GlbBufferView& view : views)
+    {
+        const std::vector<unsigned char>& bytes = options.compress ? view.encoded : view.data;
+        file.write((const char*)bytes.data(), bytes.size());
+
+        for (long long i = bytes.size(); i < align4(bytes.size()); i++)
+            file.put(0);
+    }
+
+    if (!file)
+    {
+        std::cout << "Cannot write " << path << std::endl;
+        return false;
+    }
+
+    report.rawBytes = (long long)mesh.vertices.size() * sizeof(float) + (long long)mesh.indices.size() * sizeof(unsigned int);
+    report.fileBytes = total;
+    report.indexBits = indexBits;
+    report.writeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encoded).count();
+
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "RevolutionMesh.h"
+
+class GlbExportOptions
+{
+public:
+    // KHR_mesh_quantization: positions as normalized 16-bit integers placed by the node transform,
+    // normals as normalized 8-bit integers
+    bool quantize = true;
+
+    // EXT_meshopt_compression of every buffer view, quantized normals are stored octahedral then
+    bool compress = true;
+
+    // 16 or 32, 0 picks 16 bits whenever the vertex count allows it
+    int indexBits = 0;
+};
+
+class GlbExportReport
+{
+public:
+    long long rawBytes = 0; // float positions and normals, 32-bit indices
+    long long fileBytes = 0;
+    int indexBits = 0;
+    double encodeMilliseconds = 0.0;
+    double writeMilliseconds = 0.0;
+};
+
+// Writes the mesh as a binary glTF 2.0 file with one node, one mesh and one primitive.
+// Buffer views are built and encoded in parallel.
+bool exportGlb(const RevolutionMesh& mesh, const char* path, const GlbExportOptions& options, GlbExportReport& report);
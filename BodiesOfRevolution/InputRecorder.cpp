@@ -0,0 +1,208 @@
+#include "InputRecorder.h"
+#include <iostream>
+#include <string>
+
+static const char RECORDING_MAGIC[4] = { 'B', 'O', 'R', '1' };
+
+InputRecorder* InputRecorder::instance = NULL;
+
+bool InputRecorder::startRecording(const char* path)
+{
+    this->output.open(path, std::ios::binary);
+    if (!this->output)
+    {
+        std::cout << "Cannot write input recording " << path << std::endl;
+        return false;
+    }
+
+    this->output.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    this->mode = Mode::record;
+    return true;
+}
+
+bool InputRecorder::startReplay(const char* path)
+{
+    this->input.open(path, std::ios::binary);
+
+    char magic[4] = { 0 };
+    if (!this->input || !this->input.read(magic, sizeof(magic)) || std::string(magic, 4) != std::string(RECORDING_MAGIC, 4))
+    {
+        std::cout << "Cannot read input recording " << path << std::endl;
+        return false;
+    }
+
+    this->mode = Mode::replay;
+    return true;
+}
+
+void InputRecorder::attach(GLFWwindow* window)
+{
+    this->window = window;
+    instance = this;
+
+    // Live input is ignored during a replay
+    if (this->mode == Mode::replay)
+        return;
+
+    glfwSetKeyCallback(window, onKey);
+    glfwSetMouseButtonCallback(window, onMouseButton);
+    glfwSetCursorPosCallback(window, onCursor);
+}
+
+void InputRecorder::setKeyCallback(GLFWkeyfun callback)
+{
+    this->keyCallback = callback;
+}
+
+void InputRecorder::setMouseButtonCallback(GLFWmousebuttonfun callback)
+{
+    this->mouseButtonCallback = callback;
+}
+
+void InputRecorder::setCursorCallback(GLFWcursorposfun callback)
+{
+    this->cursorCallback = callback;
+}
+
+void InputRecorder::getCursorPos(double* x, double* y)
+{
+    if (this->mode == Mode::replay)
+    {
+        *x = this->cursorX;
+        *y = this->cursorY;
+    }
+    else
+        glfwGetCursorPos(this->window, x, y);
+}
+
+void InputRecorder::recordFrame(double deltaTime)
+{
+    if (this->mode != Mode::record)
+        return;
+
+    double x, y;
+    glfwGetCursorPos(this->window, &x, &y);
+
+    write(InputEventType::frame);
+    write((float)deltaTime);
+    write(x);
+    write(y);
+}
+
+bool InputRecorder::beginFrame()
+{
+    if (!this->framePending)
+    {
+        InputEventType type;
+        if (!read(type) || type != InputEventType::frame)
+            return false;
+    }
+
+    this->framePending = false;
+    return readFrame();
+}
+
+bool InputRecorder::readFrame()
+{
+    float deltaTime;
+    return read(deltaTime) && read(this->cursorX) && read(this->cursorY);
+}
+
+void InputRecorder::dispatchEvents()
+{
+    InputEventType type;
+
+    while (read(type))
+    {
+        if (type == InputEventType::frame)
+        {
+            this->framePending = true;
+            return;
+        }
+
+        if (type == InputEventType::key)
+        {
+            int key, scancode, action, mods;
+            if (!(read(key) && read(scancode) && read(action) && read(mods)))
+                return;
+
+            if (this->keyCallback != NULL)
+                this->keyCallback(this->window, key, scancode, action, mods);
+        }
+        else if (type == InputEventType::mouseButton)
+        {
+            unsigned char button, action;
+            int mods;
+            if (!(read(button) && read(action) && read(mods) && read(this->cursorX) && read(this->cursorY)))
+                return;
+
+            if (this->mouseButtonCallback != NULL)
+                this->mouseButtonCallback(this->window, button, action, mods);
+        }
+        else if (type == InputEventType::cursor)
+        {
+            if (!(read(this->cursorX) && read(this->cursorY)))
+                return;
+
+            if (this->cursorCallback != NULL)
+                this->cursorCallback(this->window, this->cursorX, this->cursorY);
+        }
+        else
+            return;
+    }
+}
+
+void InputRecorder::finish()
+{
+    if (this->output.is_open())
+        this->output.close();
+    if (this->input.is_open())
+        this->input.close();
+}
+
+void InputRecorder::onKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (instance->mode == Mode::record)
+    {
+        instance->write(InputEventType::key);
+        instance->write(key);
+        instance->write(scancode);
+        instance->write(action);
+        instance->write(mods);
+    }
+
+    if (instance->keyCallback != NULL)
+        instance->keyCallback(window, key, scancode, action, mods);
+}
+
+void InputRecorder::onMouseButton(GLFWwindow* window, int button, int action, int mods)
+{
+    if (instance->mode == Mode::record)
+    {
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+
+        instance->write(InputEventType::mouseButton);
+        instance->write((unsigned char)button);
+        instance->write((unsigned char)action);
+        instance->write(mods);
+        instance->write(x);
+        instance->write(y);
+    }
+
+    if (instance->mouseButtonCallback != NULL)
+        instance->mouseButtonCallback(window, button, action, mods);
+}
+
+void InputRecorder::onCursor(GLFWwindow* window, double x, double y)
+{
+    if (instance->mode == Mode::record)
+    {
+        instance->write(InputEventType::cursor);
+        instance->write(x);
+        instance->write(y);
+    }
+
+    if (instance->cursorCallback != NULL)
+        instance->cursorCallback(window, x, y);
+}
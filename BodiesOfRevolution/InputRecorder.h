@@ -0,0 +1,93 @@
+#pragma once
+#include <GLFW/glfw3.h>
+#include <fstream>
+
+enum class InputEventType : unsigned char
+{
+    frame,
+    key,
+    mouseButton,
+    cursor
+};
+
+// Records window input with frame boundaries to a compact binary file and plays it back through
+// the same callbacks. A frame record carries the cursor position sampled in that frame, button
+// records carry the cursor position of the click, so replays do not depend on the live cursor.
+// The application installs and switches its callbacks through this class instead of GLFW.
+class InputRecorder
+{
+public:
+    bool startRecording(const char* path);
+
+    bool startReplay(const char* path);
+
+    bool recording() const { return this->mode == Mode::record; }
+
+    bool replaying() const { return this->mode == Mode::replay; }
+
+    void setKeyCallback(GLFWkeyfun callback);
+
+    void setMouseButtonCallback(GLFWmousebuttonfun callback);
+
+    void setCursorCallback(GLFWcursorposfun callback);
+
+    void getCursorPos(double* x, double* y);
+
+    // Recording: marks the start of a frame
+    void recordFrame(double deltaTime);
+
+    // Replay: reads the next frame marker, returns false at the end of the recording
+    bool beginFrame();
+
+    // Replay: feeds the events recorded during the current frame to the callbacks
+    void dispatchEvents();
+
+    void finish();
+
+    void attach(GLFWwindow* window);
+
+private:
+    enum class Mode
+    {
+        live,
+        record,
+        replay
+    };
+
+    Mode mode = Mode::live;
+    GLFWwindow* window = NULL;
+    std::ofstream output;
+    std::ifstream input;
+
+    GLFWkeyfun keyCallback = NULL;
+    GLFWmousebuttonfun mouseButtonCallback = NULL;
+    GLFWcursorposfun cursorCallback = NULL;
+
+    // Cursor position of the replay
+    double cursorX = 0.0, cursorY = 0.0;
+
+    // Frame marker already read by dispatchEvents
+    bool framePending = false;
+
+    static InputRecorder* instance;
+
+    static void onKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+    static void onMouseButton(GLFWwindow* window, int button, int action, int mods);
+
+    static void onCursor(GLFWwindow* window, double x, double y);
+
+    template <typename T>
+    void write(T value)
+    {
+        this->output.write((const char*)&value, sizeof(T));
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        return (bool)this->input.read((char*)&value, sizeof(T));
+    }
+
+    bool readFrame();
+};
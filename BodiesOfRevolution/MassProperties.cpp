@@ -0,0 +1,58 @@
+#include "MassProperties.h"
+#include "Parallel.h"
+
+// 8-point Gauss-Legendre rule on [0; 1]. Volume and centroid integrands are polynomials
+// of degree 8 and 11 on a cubic segment, so they are integrated exactly.
+static const int GAUSS_POINTS = 8;
+
+static const double GAUSS_NODES[GAUSS_POINTS] =
+{
+    0.019855071751231856, 0.10166676129318664, 0.2372337950418355, 0.40828267875217505,
+    0.591717321247825, 0.7627662049581645, 0.8983332387068134, 0.9801449282487681
+};
+
+static const double GAUSS_WEIGHTS[GAUSS_POINTS] =
+{
+    0.05061426814518813, 0.11119051722668724, 0.15685332293894364, 0.18134189168918100,
+    0.18134189168918100, 0.15685332293894364, 0.11119051722668724, 0.05061426814518813
+};
+
+static const double PI_D = 3.14159265358979323846;
+
+MassProperties computeMassProperties(const std::vector<Segment>& segments)
+{
+    MassProperties result;
+
+    // Pappus-Guldinus: dV = pi y^2 dx, dA = 2 pi |y| ds, x V = integral of pi x y^2 dx
+    double volume = 0.0, moment = 0.0, area = 0.0;
+
+    for (const Segment& segment : segments)
+        for (int i = 0; i < GAUSS_POINTS; i++)
+        {
+            Point2D p = segment.calc(GAUSS_NODES[i]);
+            Point2D d = segment.derivative(GAUSS_NODES[i]);
+            double w = GAUSS_WEIGHTS[i];
+
+            volume += w * p.y * p.y * d.x;
+            moment += w * p.x * p.y * p.y * d.x;
+            area += w * fabs(p.y) * sqrt(d.x * d.x + d.y * d.y);
+        }
+
+    // The sign only depends on the direction the profile was drawn in
+    result.volume = PI_D * fabs(volume);
+    result.surfaceArea = 2.0 * PI_D * area;
+    result.centroidX = IS_ZERO(volume) ? 0.0 : moment / volume;
+
+    return result;
+}
+
+void computeMassProperties(const std::vector<std::vector<Segment>>& profiles, std::vector<MassProperties>& results)
+{
+    results.resize(profiles.size());
+
+    parallelFor(profiles.size(), 64, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+            results[i] = computeMassProperties(profiles[i]);
+    });
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+#include "tbezier.h"
+
+// Mass properties of the solid swept by a profile around the x axis, in profile units.
+// The solid is bounded by the surface of revolution and the planes through the profile end points.
+class MassProperties
+{
+public:
+    double volume = 0.0;
+    double surfaceArea = 0.0; // lateral surface only
+    double centroidX = 0.0;   // the centroid lies on the axis
+};
+
+MassProperties computeMassProperties(const std::vector<Segment>& segments);
+
+void computeMassProperties(const std::vector<std::vector<Segment>>& profiles, std::vector<MassProperties>& results);
@@ -0,0 +1,102 @@
+#include "MemoryRegistry.h"
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static const int SUBSYSTEM_COUNT = (int)MemorySubsystem::count;
+
+static const char* SUBSYSTEM_NAMES[SUBSYSTEM_COUNT] = { "points", "curve", "edit worker", "body", "tessellation", "overlay", "uniforms", "history", "section" };
+
+class AtomicStats
+{
+public:
+    std::atomic<long long> cpuBytes{ 0 }, cpuPeak{ 0 }, cpuResizes{ 0 };
+    std::atomic<long long> gpuBytes{ 0 }, gpuPeak{ 0 }, gpuAllocations{ 0 };
+};
+
+static AtomicStats g_stats[SUBSYSTEM_COUNT];
+
+static void raisePeak(std::atomic<long long>& peak, long long value)
+{
+    long long current = peak.load();
+    while (value > current && !peak.compare_exchange_weak(current, value))
+        ;
+}
+
+void MemoryRegistry::setCpuBytes(MemorySubsystem subsystem, long long bytes)
+{
+    AtomicStats& s = g_stats[(int)subsystem];
+
+    if (s.cpuBytes.exchange(bytes) != bytes)
+        s.cpuResizes++;
+    raisePeak(s.cpuPeak, bytes);
+}
+
+void MemoryRegistry::addGpuBytes(MemorySubsystem subsystem, long long bytes)
+{
+    AtomicStats& s = g_stats[(int)subsystem];
+
+    if (bytes > 0)
+        s.gpuAllocations++;
+    raisePeak(s.gpuPeak, s.gpuBytes += bytes);
+}
+
+MemoryStats MemoryRegistry::stats(MemorySubsystem subsystem)
+{
+    const AtomicStats& s = g_stats[(int)subsystem];
+
+    MemoryStats result;
+    result.cpuBytes = s.cpuBytes;
+    result.cpuPeak = s.cpuPeak;
+    result.cpuResizes = s.cpuResizes;
+    result.gpuBytes = s.gpuBytes;
+    result.gpuPeak = s.gpuPeak;
+    result.gpuAllocations = s.gpuAllocations;
+
+    return result;
+}
+
+MemoryStats MemoryRegistry::total()
+{
+    // Peaks of different subsystems need not coincide, the total peak is an upper bound
+    MemoryStats result;
+    for (int i = 0; i < SUBSYSTEM_COUNT; i++)
+    {
+        MemoryStats s = stats((MemorySubsystem)i);
+        result.cpuBytes += s.cpuBytes, result.cpuPeak += s.cpuPeak, result.cpuResizes += s.cpuResizes;
+        result.gpuBytes += s.gpuBytes, result.gpuPeak += s.gpuPeak, result.gpuAllocations += s.gpuAllocations;
+    }
+
+    return result;
+}
+
+const char* MemoryRegistry::name(MemorySubsystem subsystem)
+{
+    return SUBSYSTEM_NAMES[(int)subsystem];
+}
+
+std::string MemoryRegistry::summary()
+{
+    MemoryStats s = total();
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << "CPU " << s.cpuBytes / 1024.0 << " KB, GPU " << s.gpuBytes / 1024.0 << " KB";
+    return out.str();
+}
+
+void MemoryRegistry::print()
+{
+    std::cout << std::left << std::setw(14) << "subsystem" << std::right
+        << std::setw(12) << "CPU KB" << std::setw(12) << "peak" << std::setw(9) << "resizes"
+        << std::setw(12) << "GPU KB" << std::setw(12) << "peak" << std::setw(9) << "allocs" << std::endl;
+
+    for (int i = 0; i <= SUBSYSTEM_COUNT; i++)
+    {
+        MemoryStats s = i < SUBSYSTEM_COUNT ? stats((MemorySubsystem)i) : total();
+
+        std::cout << std::left << std::setw(14) << (i < SUBSYSTEM_COUNT ? SUBSYSTEM_NAMES[i] : "total") << std::right << std::fixed << std::setprecision(1)
+            << std::setw(12) << s.cpuBytes / 1024.0 << std::setw(12) << s.cpuPeak / 1024.0 << std::setw(9) << s.cpuResizes
+            << std::setw(12) << s.gpuBytes / 1024.0 << std::setw(12) << s.gpuPeak / 1024.0 << std::setw(9) << s.gpuAllocations << std::endl;
+    }
+}
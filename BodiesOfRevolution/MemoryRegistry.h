@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+
+enum class MemorySubsystem
+{
+    points,
+    curve,
+    editWorker,
+    body,
+    tessellation,
+    overlay,
+    uniforms,
+    history,
+    section,
+    count
+};
+
+class MemoryStats
+{
+public:
+    long long cpuBytes = 0;
+    long long cpuPeak = 0;
+    long long cpuResizes = 0;   // changes of the reported CPU capacity
+
+    long long gpuBytes = 0;
+    long long gpuPeak = 0;
+    long long gpuAllocations = 0; // buffer storage (re)allocations
+};
+
+// Live CPU and GPU memory of every subsystem. GPU bytes are reported by Model for every buffer
+// storage it allocates; CPU bytes are the vector capacities a subsystem reports after it changes.
+// Counters are atomic, the edit worker reports from its own thread.
+class MemoryRegistry
+{
+public:
+    static void setCpuBytes(MemorySubsystem subsystem, long long bytes);
+
+    static void addGpuBytes(MemorySubsystem subsystem, long long bytes);
+
+    static MemoryStats stats(MemorySubsystem subsystem);
+
+    static MemoryStats total();
+
+    static const char* name(MemorySubsystem subsystem);
+
+    // One line for the window title
+    static std::string summary();
+
+    // Table of all subsystems on the console
+    static void print();
+};
+
+// Bytes held by a vector, including unused capacity
+template <typename Vector>
+long long vectorBytes(const Vector& v)
+{
+    return (long long)v.capacity() * sizeof(typename Vector::value_type);
+}
@@ -0,0 +1,181 @@
+#include "MeshCodec.h"
+#include "Parallel.h"
+
+static const int GROUP_BITS[4] = { 0, 2, 4, 8 };
+
+static unsigned char zigzag8(unsigned char v)
+{
+    return (unsigned char)(((signed char)v >> 7) ^ (v << 1));
+}
+
+// Bytes a group of values takes with the given width, -1 when zero width does not fit
+static int measureGroup(const unsigned char* values, int bits)
+{
+    if (bits == 0)
+    {
+        for (int i = 0; i < CODEC_GROUP_SIZE; i++)
+            if (values[i] != 0)
+                return -1;
+        return 0;
+    }
+
+    if (bits == 8)
+        return CODEC_GROUP_SIZE;
+
+    // Values that do not fit are stored whole after the packed part, the all-ones code marks them
+    int result = CODEC_GROUP_SIZE * bits / 8;
+    unsigned char sentinel = (1 << bits) - 1;
+    for (int i = 0; i < CODEC_GROUP_SIZE; i++)
+        result += values[i] >= sentinel;
+
+    return result;
+}
+
+static void encodeGroup(const unsigned char* values, int bits, std::vector<unsigned char>& output)
+{
+    if (bits == 0)
+        return;
+
+    if (bits == 8)
+    {
+        output.insert(output.end(), values, values + CODEC_GROUP_SIZE);
+        return;
+    }
+
+    int perByte = 8 / bits;
+    unsigned char sentinel = (1 << bits) - 1;
+
+    // The first value goes to the high bits
+    for (int i = 0; i < CODEC_GROUP_SIZE; i += perByte)
+    {
+        unsigned char byte = 0;
+        for (int k = 0; k < perByte; k++)
+            byte = (byte << bits) | (values[i + k] >= sentinel ? sentinel : values[i + k]);
+        output.push_back(byte);
+    }
+
+    for (int i = 0; i < CODEC_GROUP_SIZE; i++)
+        if (values[i] >= sentinel)
+            output.push_back(values[i]);
+}
+
+// size is a multiple of the group size; a header with 2 bits per group selects the widths
+static void encodeBytes(const unsigned char* values, int size, std::vector<unsigned char>& output)
+{
+    int groups = size / CODEC_GROUP_SIZE;
+    size_t header = output.size();
+    output.resize(header + (groups + 3) / 4, 0);
+
+    for (int g = 0; g < groups; g++)
+    {
+        const unsigned char* group = values + g * CODEC_GROUP_SIZE;
+
+        int best = 3;
+        int bestSize = measureGroup(group, 8);
+        for (int k = 0; k < 3; k++)
+        {
+            int size = measureGroup(group, GROUP_BITS[k]);
+            if (size >= 0 && size < bestSize)
+            {
+                best = k;
+                bestSize = size;
+            }
+        }
+
+        output[header + g / 4] |= best << ((g % 4) * 2);
+        encodeGroup(group, GROUP_BITS[best], output);
+    }
+}
+
+static void encodeVertexBlock(const unsigned char* vertices, int count, int stride, const unsigned char* previous,
+    std::vector<unsigned char>& output)
+{
+    // Values past the end of the block only round the last group up and are zero
+    unsigned char deltas[CODEC_BLOCK_MAX_VERTICES] = { 0 };
+    int padded = (count + CODEC_GROUP_SIZE - 1) & ~(CODEC_GROUP_SIZE - 1);
+
+    for (int k = 0; k < stride; k++)
+    {
+        unsigned char p = previous[k];
+        for (int i = 0; i < count; i++)
+        {
+            unsigned char v = vertices[i * stride + k];
+            deltas[i] = zigzag8(v - p);
+            p = v;
+        }
+
+        encodeBytes(deltas, padded, output);
+    }
+}
+
+void encodeVertexBuffer(const unsigned char* vertices, int count, int stride, std::vector<unsigned char>& output)
+{
+    output.clear();
+    output.push_back(CODEC_VERTEX_HEADER);
+
+    int blockSize = (CODEC_BLOCK_BYTES / stride) & ~(CODEC_GROUP_SIZE - 1);
+    if (blockSize > CODEC_BLOCK_MAX_VERTICES)
+        blockSize = CODEC_BLOCK_MAX_VERTICES;
+
+    int blockCount = (count + blockSize - 1) / blockSize;
+    std::vector<std::vector<unsigned char>> blocks(blockCount);
+
+    // Every block is delta coded against the last vertex of the previous one, the first against itself
+    parallelFor(blockCount, 64, [&](int begin, int end)
+    {
+        for (int b = begin; b < end; b++)
+        {
+            int first = b * blockSize;
+            int n = count - first < blockSize ? count - first : blockSize;
+            const unsigned char* previous = vertices + (b == 0 ? 0 : (first - 1) * stride);
+
+            blocks[b].reserve(n * stride);
+            encodeVertexBlock(vertices + first * stride, n, stride, previous, blocks[b]);
+        }
+    });
+
+    for (const std::vector<unsigned char>& block : blocks)
+        output.insert(output.end(), block.begin(), block.end());
+
+    if (stride < CODEC_TAIL_SIZE)
+        output.resize(output.size() + CODEC_TAIL_SIZE - stride, 0);
+
+    if (count > 0)
+        output.insert(output.end(), vertices, vertices + stride);
+    else
+        output.resize(output.size() + stride, 0);
+}
+
+void encodeIndexSequence(const unsigned int* indices, int count, std::vector<unsigned char>& output)
+{
+    output.clear();
+    output.reserve(count + 5);
+    output.push_back(CODEC_INDEX_SEQUENCE_HEADER);
+
+    unsigned int last[2] = { 0, 0 };
+    int current = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        unsigned int index = indices[i];
+
+        // Switch to the other baseline when the delta would not fit in one byte
+        int cd = (int)(index - last[current]);
+        current ^= (cd < 0 ? -cd : cd) >= 30;
+
+        // Low bit: baseline, next bit: sign of the delta
+        unsigned int d = index - last[current];
+        unsigned int v = (((d << 1) ^ (unsigned int)((int)d >> 31)) << 1) | current;
+
+        while (v >= 128)
+        {
+            output.push_back((v & 127) | 128);
+            v >>= 7;
+        }
+        output.push_back(v);
+
+        last[current] = index;
+    }
+
+    output.resize(output.size() + 4, 0);
+}
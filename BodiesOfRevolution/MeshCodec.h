@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+
+// Encoders for the bitstreams of the glTF EXT_meshopt_compression extension, so exported files
+// decode in any viewer that supports it.
+//
+// ATTRIBUTES: vertices are split into blocks, every byte of the vertex is delta coded against
+// the previous vertex, zigzagged and packed in groups of 16 with 0, 2, 4 or 8 bits per value.
+// Blocks only depend on the input, so they are encoded in parallel.
+//
+// INDICES: every index is a zigzagged varint delta against one of two baselines.
+
+#define CODEC_VERTEX_HEADER 0xa0
+#define CODEC_INDEX_SEQUENCE_HEADER 0xd1
+
+// Vertex bytes per block of the ATTRIBUTES codec, and the block size limit in vertices
+#define CODEC_BLOCK_BYTES 8192
+#define CODEC_BLOCK_MAX_VERTICES 256
+#define CODEC_GROUP_SIZE 16
+
+// The first vertex is repeated at the end of the stream, padded to at least this many bytes
+#define CODEC_TAIL_SIZE 32
+
+// stride is a multiple of 4, at most 256 bytes
+void encodeVertexBuffer(const unsigned char* vertices, int count, int stride, std::vector<unsigned char>& output);
+
+void encodeIndexSequence(const unsigned int* indices, int count, std::vector<unsigned char>& output);
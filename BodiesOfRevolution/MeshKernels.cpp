@@ -0,0 +1,63 @@
+#include "MeshKernels.h"
+
+static const double TWO_PI = 6.283185307179586;
+
+void sampleSegmentGeneric(const Segment& segment, int samples, Point2D* points, Point2D* tangents)
+{
+    for (int i = 0; i < samples; ++i)
+    {
+        double t = (double)i / (double)samples;
+
+        points[i] = segment.calc(t);
+        tangents[i] = segment.tangent(t);
+    }
+}
+
+void revolveGeneric(float x, float y, float nx, float ny, int revolutions, float* out)
+{
+    for (int r = 0; r < revolutions; r++)
+    {
+        double angle = TWO_PI * r / revolutions;
+        float c = cos(angle);
+        float s = sin(angle);
+
+        out[6 * r] = x;
+        out[6 * r + 1] = y * c;
+        out[6 * r + 2] = y * s;
+        out[6 * r + 3] = nx;
+        out[6 * r + 4] = ny * c;
+        out[6 * r + 5] = ny * s;
+    }
+}
+
+SampleKernel findSampleKernel(int samples)
+{
+    switch (samples)
+    {
+    case 8:
+        return sampleSegmentFixed<8>;
+    case 16:
+        return sampleSegmentFixed<16>;
+    case 32:
+        return sampleSegmentFixed<32>;
+    default:
+        return NULL;
+    }
+}
+
+RevolveKernel findRevolveKernel(int revolutions)
+{
+    switch (revolutions)
+    {
+    case 32:
+        return revolveFixed<32>;
+    case 64:
+        return revolveFixed<64>;
+    case 128:
+        return revolveFixed<128>;
+    case 256:
+        return revolveFixed<256>;
+    default:
+        return NULL;
+    }
+}
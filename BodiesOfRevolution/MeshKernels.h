@@ -0,0 +1,153 @@
+#pragma once
+#include <math.h>
+#include "tbezier.h"
+
+// Meshing inner loops specialized at compile time on the sample count of a segment and the
+// revolution count of a ring. Bernstein weights and the ring's cos/sin are constexpr tables,
+// the loops have constant trip counts and unroll. find*Kernel() picks the specialization for
+// a runtime setting and returns NULL when there is none, the generic functions cover the rest.
+
+namespace kernels
+{
+    // Taylor series for |x| <= pi/2, accurate to double precision
+    constexpr double taylorSin(double x)
+    {
+        double term = x, sum = x;
+        for (int i = 1; i < 14; i++)
+        {
+            term *= -x * x / ((2 * i) * (2 * i + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double taylorCos(double x)
+    {
+        double term = 1.0, sum = 1.0;
+        for (int i = 1; i < 14; i++)
+        {
+            term *= -x * x / ((2 * i - 1) * (2 * i));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // cos and sin of 2 pi r / N for every r, quarter turns are reduced exactly
+    template <int N>
+    class RingTable
+    {
+    public:
+        float cosines[N];
+        float sines[N];
+
+        constexpr RingTable() : cosines(), sines()
+        {
+            for (int r = 0; r < N; r++)
+            {
+                int quarter = 4 * r / N;
+                double x = 1.5707963267948966 * (4 * r - quarter * N) / N;
+                double s = taylorSin(x), c = taylorCos(x);
+
+                double rs = quarter == 0 ? s : quarter == 1 ? c : quarter == 2 ? -s : -c;
+                double rc = quarter == 0 ? c : quarter == 1 ? -s : quarter == 2 ? -c : s;
+
+                this->cosines[r] = (float)rc;
+                this->sines[r] = (float)rs;
+            }
+        }
+    };
+
+    // Cubic Bernstein weights and their derivatives at t = i / S. Products are grouped like in
+    // Segment::calc and Segment::derivative, so the kernel gives the same bits as those.
+    template <int S>
+    class BernsteinTable
+    {
+    public:
+        double w[S][4];
+        double dw[S][3];
+
+        constexpr BernsteinTable() : w(), dw()
+        {
+            for (int i = 0; i < S; i++)
+            {
+                double t = (double)i / S, nt = 1.0 - t;
+                double t2 = t * t, nt2 = nt * nt;
+
+                this->w[i][0] = nt2 * nt;
+                this->w[i][1] = 3.0 * t * nt2;
+                this->w[i][2] = 3.0 * t2 * nt;
+                this->w[i][3] = t2 * t;
+
+                // Without the factor 3, which is applied to the sum
+                this->dw[i][0] = nt2;
+                this->dw[i][1] = 2.0 * t * nt;
+                this->dw[i][2] = t2;
+            }
+        }
+    };
+
+    // Same result as Segment::tangent for the derivative (dx, dy) at t
+    inline Point2D unitTangent(const Segment& segment, double dx, double dy, double t)
+    {
+        if (fabs(dx) < EPSILON && fabs(dy) < EPSILON)
+            return segment.tangent(t);
+
+        Point2D d(dx, dy);
+        d.normalize();
+        return d;
+    }
+}
+
+typedef void (*SampleKernel)(const Segment& segment, Point2D* points, Point2D* tangents);
+
+typedef void (*RevolveKernel)(float x, float y, float nx, float ny, float* out);
+
+// Samples t = i / SAMPLES for i < SAMPLES, the end point belongs to the next segment
+template <int SAMPLES>
+void sampleSegmentFixed(const Segment& segment, Point2D* points, Point2D* tangents)
+{
+    static constexpr kernels::BernsteinTable<SAMPLES> table{};
+
+    const Point2D* p = segment.points;
+    double ex0 = p[1].x - p[0].x, ex1 = p[2].x - p[1].x, ex2 = p[3].x - p[2].x;
+    double ey0 = p[1].y - p[0].y, ey1 = p[2].y - p[1].y, ey2 = p[3].y - p[2].y;
+
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        const double* w = table.w[i];
+        const double* dw = table.dw[i];
+
+        points[i] = Point2D(w[0] * p[0].x + w[1] * p[1].x + w[2] * p[2].x + w[3] * p[3].x,
+            w[0] * p[0].y + w[1] * p[1].y + w[2] * p[2].y + w[3] * p[3].y);
+
+        tangents[i] = kernels::unitTangent(segment, 3.0 * (dw[0] * ex0 + dw[1] * ex1 + dw[2] * ex2),
+            3.0 * (dw[0] * ey0 + dw[1] * ey1 + dw[2] * ey2), (double)i / SAMPLES);
+    }
+}
+
+// Writes REVOLUTIONS vertices (position and normal) of the ring of a profile point
+template <int REVOLUTIONS>
+void revolveFixed(float x, float y, float nx, float ny, float* out)
+{
+    static constexpr kernels::RingTable<REVOLUTIONS> table{};
+
+    for (int r = 0; r < REVOLUTIONS; r++)
+    {
+        float c = table.cosines[r], s = table.sines[r];
+
+        out[6 * r] = x;
+        out[6 * r + 1] = y * c;
+        out[6 * r + 2] = y * s;
+        out[6 * r + 3] = nx;
+        out[6 * r + 4] = ny * c;
+        out[6 * r + 5] = ny * s;
+    }
+}
+
+void sampleSegmentGeneric(const Segment& segment, int samples, Point2D* points, Point2D* tangents);
+
+void revolveGeneric(float x, float y, float nx, float ny, int revolutions, float* out);
+
+SampleKernel findSampleKernel(int samples);
+
+RevolveKernel findRevolveKernel(int revolutions);
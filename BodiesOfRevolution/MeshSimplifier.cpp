@@ -0,0 +1,423 @@
+#include "MeshSimplifier.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+// Collapses that turn a face normal by more than about 78 degrees are rejected
+static const double MIN_NORMAL_COSINE = 0.2;
+
+void Quadric::addPlane(double a, double b, double c, double d, double weight)
+{
+    this->q[0] += weight * a * a, this->q[1] += weight * a * b, this->q[2] += weight * a * c, this->q[3] += weight * a * d;
+    this->q[4] += weight * b * b, this->q[5] += weight * b * c, this->q[6] += weight * b * d;
+    this->q[7] += weight * c * c, this->q[8] += weight * c * d;
+    this->q[9] += weight * d * d;
+}
+
+void Quadric::add(const Quadric& other)
+{
+    for (int i = 0; i < 10; i++)
+        this->q[i] += other.q[i];
+}
+
+double Quadric::evaluate(double x, double y, double z) const
+{
+    return this->q[0] * x * x + 2.0 * this->q[1] * x * y + 2.0 * this->q[2] * x * z + 2.0 * this->q[3] * x
+        + this->q[4] * y * y + 2.0 * this->q[5] * y * z + 2.0 * this->q[6] * y
+        + this->q[7] * z * z + 2.0 * this->q[8] * z
+        + this->q[9];
+}
+
+static void faceNormal(const float* a, const float* b, const float* c, double n[3])
+{
+    double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+bool MeshSimplifier::simplify(const RevolutionMesh& input, RevolutionMesh& output, int targetTriangles, double errorBound)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    const int vertexCount = input.vertexCount();
+    const int faceCount = input.triangleCount();
+
+    this->inputTriangles = this->outputTriangles = faceCount;
+    this->collapses = 0;
+    this->maxError = 0.0;
+    this->milliseconds = 0.0;
+
+    output.vertices = input.vertices;
+    output.indices = input.indices;
+    output.revolutions = input.revolutions;
+    output.poleCount = input.poleCount;
+
+    if (faceCount == 0 || (targetTriangles <= 0 && errorBound <= 0.0))
+        return false;
+
+    this->positions.resize(3 * vertexCount);
+    for (int i = 0; i < vertexCount; i++)
+        for (int k = 0; k < 3; k++)
+            this->positions[3 * i + k] = input.vertices[6 * i + k];
+
+    this->faces = input.indices;
+    this->faceRemoved.assign(faceCount, 0);
+    this->vertexRemoved.assign(vertexCount, 0);
+    this->stamp.assign(vertexCount, 0);
+
+    this->vertexFaces.assign(vertexCount, std::vector<int>());
+    for (int f = 0; f < faceCount; f++)
+        for (int k = 0; k < 3; k++)
+            this->vertexFaces[this->faces[3 * f + k]].push_back(f);
+
+    findBoundary();
+    initQuadrics();
+
+    // Both directions of every face edge, interior edges appear twice and the stale copy is skipped later
+    this->heap.resize(6 * faceCount);
+    parallelFor(faceCount, 4096, [&](int begin, int end)
+    {
+        for (int f = begin; f < end; f++)
+            for (int k = 0; k < 3; k++)
+            {
+                int a = this->faces[3 * f + k], b = this->faces[3 * f + (k + 1) % 3];
+                this->heap[6 * f + 2 * k] = candidate(a, b);
+                this->heap[6 * f + 2 * k + 1] = candidate(b, a);
+            }
+    });
+    std::make_heap(this->heap.begin(), this->heap.end());
+
+    int triangles = faceCount;
+
+    while (!this->heap.empty())
+    {
+        if (targetTriangles > 0 && triangles <= targetTriangles)
+            break;
+
+        std::pop_heap(this->heap.begin(), this->heap.end());
+        Candidate c = this->heap.back();
+        this->heap.pop_back();
+
+        if (this->vertexRemoved[c.from] || this->vertexRemoved[c.to] ||
+            this->stamp[c.from] != c.fromStamp || this->stamp[c.to] != c.toStamp)
+            continue;
+
+        // Costs sum many weighted planes, so a cheap collapse may still move the surface too far
+        double error = planeError(c.from, c.to);
+        if (errorBound > 0.0 && error > errorBound)
+            continue;
+
+        if (!canCollapse(c.from, c.to))
+            continue;
+
+        triangles -= collapse(c.from, c.to);
+        this->maxError = std::max(this->maxError, error);
+        this->collapses++;
+    }
+
+    // Compact the surviving vertices, they keep their original position and normal
+    std::vector<int> remap(vertexCount, -1);
+    output.vertices.clear();
+    output.indices.clear();
+
+    for (int f = 0; f < faceCount; f++)
+    {
+        if (this->faceRemoved[f])
+            continue;
+
+        for (int k = 0; k < 3; k++)
+        {
+            int v = this->faces[3 * f + k];
+            if (remap[v] < 0)
+            {
+                remap[v] = output.vertices.size() / 6;
+                output.vertices.insert(output.vertices.end(), input.vertices.begin() + 6 * v, input.vertices.begin() + 6 * v + 6);
+            }
+            output.indices.push_back(remap[v]);
+        }
+    }
+
+    this->outputTriangles = output.triangleCount();
+    this->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return true;
+}
+
+void MeshSimplifier::findBoundary()
+{
+    const int faceCount = this->faces.size() / 3;
+
+    // Edges used by a single face; keys are sorted so that both uses of an edge are adjacent
+    std::vector<std::pair<long long, int>> edges(3 * faceCount);
+    for (int f = 0; f < faceCount; f++)
+        for (int k = 0; k < 3; k++)
+        {
+            long long a = this->faces[3 * f + k], b = this->faces[3 * f + (k + 1) % 3];
+            edges[3 * f + k] = std::make_pair(a < b ? (a << 32) | b : (b << 32) | a, f);
+        }
+    std::sort(edges.begin(), edges.end());
+
+    this->boundary.assign(this->vertexRemoved.size(), 0);
+    this->boundaryEdges.clear();
+
+    for (size_t i = 0; i < edges.size(); )
+    {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j].first == edges[i].first)
+            j++;
+
+        if (j - i == 1)
+        {
+            int a = (int)(edges[i].first >> 32), b = (int)(edges[i].first & 0xffffffff);
+            this->boundary[a] = this->boundary[b] = 1;
+            this->boundaryEdges.push_back(a);
+            this->boundaryEdges.push_back(b);
+            this->boundaryEdges.push_back(edges[i].second);
+        }
+
+        i = j;
+    }
+}
+
+void MeshSimplifier::initQuadrics()
+{
+    const int faceCount = this->faces.size() / 3;
+    const int vertexCount = this->vertexRemoved.size();
+
+    // Degenerate faces keep a zero plane, which is at distance zero from everything
+    this->planes.assign(4 * faceCount, 0.0);
+    std::vector<Quadric> faceQuadrics(faceCount);
+    parallelFor(faceCount, 4096, [&](int begin, int end)
+    {
+        for (int f = begin; f < end; f++)
+        {
+            const float* a = &this->positions[3 * this->faces[3 * f]];
+            double n[3];
+            faceNormal(a, &this->positions[3 * this->faces[3 * f + 1]], &this->positions[3 * this->faces[3 * f + 2]], n);
+
+            double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length == 0.0)
+                continue;
+
+            double* plane = &this->planes[4 * f];
+            plane[0] = n[0] / length, plane[1] = n[1] / length, plane[2] = n[2] / length;
+            plane[3] = -(plane[0] * a[0] + plane[1] * a[1] + plane[2] * a[2]);
+            faceQuadrics[f].addPlane(plane[0], plane[1], plane[2], plane[3], 1.0);
+        }
+    });
+
+    // Every vertex sums its own faces, so the threads never write to the same quadric
+    this->quadrics.assign(vertexCount, Quadric());
+    this->vertexPlanes.resize(vertexCount);
+    parallelFor(vertexCount, 4096, [&](int begin, int end)
+    {
+        for (int v = begin; v < end; v++)
+        {
+            for (int f : this->vertexFaces[v])
+                this->quadrics[v].add(faceQuadrics[f]);
+            this->vertexPlanes[v] = this->vertexFaces[v];
+        }
+    });
+
+    // A plane through every boundary edge, perpendicular to its face, keeps the silhouette of open ends
+    for (size_t i = 0; i < this->boundaryEdges.size(); i += 3)
+    {
+        int a = this->boundaryEdges[i], b = this->boundaryEdges[i + 1], f = this->boundaryEdges[i + 2];
+        const float* pa = &this->positions[3 * a];
+        const float* pb = &this->positions[3 * b];
+
+        double n[3];
+        faceNormal(&this->positions[3 * this->faces[3 * f]], &this->positions[3 * this->faces[3 * f + 1]], &this->positions[3 * this->faces[3 * f + 2]], n);
+
+        double e[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+        double p[3] = { e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0] };
+
+        double length = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (length == 0.0)
+            continue;
+
+        p[0] /= length, p[1] /= length, p[2] /= length;
+        double d = -(p[0] * pa[0] + p[1] * pa[1] + p[2] * pa[2]);
+
+        this->quadrics[a].addPlane(p[0], p[1], p[2], d, BOUNDARY_WEIGHT);
+        this->quadrics[b].addPlane(p[0], p[1], p[2], d, BOUNDARY_WEIGHT);
+
+        int plane = this->planes.size() / 4;
+        this->planes.insert(this->planes.end(), { p[0], p[1], p[2], d });
+        this->vertexPlanes[a].push_back(plane);
+        this->vertexPlanes[b].push_back(plane);
+    }
+}
+
+MeshSimplifier::Candidate MeshSimplifier::candidate(int from, int to) const
+{
+    Quadric q = this->quadrics[from];
+    q.add(this->quadrics[to]);
+
+    const float* p = &this->positions[3 * to];
+
+    Candidate c;
+    c.cost = std::max(0.0, q.evaluate(p[0], p[1], p[2]));
+    c.from = from;
+    c.to = to;
+    c.fromStamp = this->stamp[from];
+    c.toStamp = this->stamp[to];
+
+    return c;
+}
+
+double MeshSimplifier::planeError(int from, int to) const
+{
+    const float* p = &this->positions[3 * to];
+    double result = 0.0;
+
+    for (int v : { from, to })
+        for (int i : this->vertexPlanes[v])
+        {
+            const double* plane = &this->planes[4 * i];
+            result = std::max(result, fabs(plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3]));
+        }
+
+    return result;
+}
+
+bool MeshSimplifier::canCollapse(int from, int to)
+{
+    int shared = sharedFaces(from, to);
+    if (shared == 0)
+        return false;
+
+    // Boundary vertices may only slide along their own boundary
+    if (this->boundary[from] && !(this->boundary[to] && shared == 1))
+        return false;
+
+    // Link condition: the edge may only share the vertices opposite to its own faces
+    neighbours(from, this->scratch);
+    neighbours(to, this->scratchOther);
+
+    int common = 0;
+    for (int v : this->scratch)
+        if (std::find(this->scratchOther.begin(), this->scratchOther.end(), v) != this->scratchOther.end())
+            common++;
+    if (common > shared)
+        return false;
+
+    // No remaining face may flip or degenerate
+    for (int f : this->vertexFaces[from])
+    {
+        if (this->faceRemoved[f])
+            continue;
+
+        unsigned int* face = &this->faces[3 * f];
+        if (face[0] == (unsigned int)to || face[1] == (unsigned int)to || face[2] == (unsigned int)to)
+            continue;
+
+        const float* p[3];
+        const float* q[3];
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = &this->positions[3 * face[k]];
+            q[k] = face[k] == (unsigned int)from ? &this->positions[3 * to] : p[k];
+        }
+
+        double before[3], after[3];
+        faceNormal(p[0], p[1], p[2], before);
+        faceNormal(q[0], q[1], q[2], after);
+
+        double lengthBefore = sqrt(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]);
+        double lengthAfter = sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+        double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+
+        if (lengthAfter < 1.0e-12 * lengthBefore || dot < MIN_NORMAL_COSINE * lengthBefore * lengthAfter)
+            return false;
+    }
+
+    return true;
+}
+
+int MeshSimplifier::collapse(int from, int to)
+{
+    int removed = 0;
+
+    for (int f : this->vertexFaces[from])
+    {
+        if (this->faceRemoved[f])
+            continue;
+
+        unsigned int* face = &this->faces[3 * f];
+        if (face[0] == (unsigned int)to || face[1] == (unsigned int)to || face[2] == (unsigned int)to)
+        {
+            this->faceRemoved[f] = 1;
+            removed++;
+            continue;
+        }
+
+        for (int k = 0; k < 3; k++)
+            if (face[k] == (unsigned int)from)
+                face[k] = to;
+        this->vertexFaces[to].push_back(f);
+    }
+
+    this->vertexFaces[from].clear();
+    this->vertexRemoved[from] = 1;
+    this->quadrics[to].add(this->quadrics[from]);
+
+    // Both vertices share the planes of their common faces
+    std::vector<int>& merged = this->vertexPlanes[to];
+    merged.insert(merged.end(), this->vertexPlanes[from].begin(), this->vertexPlanes[from].end());
+    std::sort(merged.begin(), merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    this->vertexPlanes[from].clear();
+    this->stamp[to]++;
+
+    // Faces removed around to stay in its list and are skipped from now on
+    neighbours(to, this->scratch);
+    for (int w : this->scratch)
+    {
+        this->heap.push_back(candidate(w, to));
+        std::push_heap(this->heap.begin(), this->heap.end());
+        this->heap.push_back(candidate(to, w));
+        std::push_heap(this->heap.begin(), this->heap.end());
+    }
+
+    return removed;
+}
+
+void MeshSimplifier::neighbours(int v, std::vector<int>& out) const
+{
+    out.clear();
+
+    for (int f : this->vertexFaces[v])
+    {
+        if (this->faceRemoved[f])
+            continue;
+
+        for (int k = 0; k < 3; k++)
+        {
+            int w = this->faces[3 * f + k];
+            if (w != v && std::find(out.begin(), out.end(), w) == out.end())
+                out.push_back(w);
+        }
+    }
+}
+
+int MeshSimplifier::sharedFaces(int u, int v) const
+{
+    int count = 0;
+
+    for (int f : this->vertexFaces[u])
+    {
+        if (this->faceRemoved[f])
+            continue;
+
+        const unsigned int* face = &this->faces[3 * f];
+        if (face[0] == (unsigned int)v || face[1] == (unsigned int)v || face[2] == (unsigned int)v)
+            count++;
+    }
+
+    return count;
+}
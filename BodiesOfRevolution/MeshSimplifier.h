@@ -0,0 +1,87 @@
+#pragma once
+#include <vector>
+#include "RevolutionMesh.h"
+
+// Weight of the planes that hold open boundary rings (profile ends off the axis) in place
+#define BOUNDARY_WEIGHT 1000.0
+
+// Symmetric 4x4 error quadric of a set of planes, upper triangle stored row by row
+class Quadric
+{
+public:
+    double q[10] = { 0.0 };
+
+    void addPlane(double a, double b, double c, double d, double weight);
+
+    void add(const Quadric& other);
+
+    double evaluate(double x, double y, double z) const;
+};
+
+// Quadric error edge collapse (Garland-Heckbert) that reduces a body mesh to a triangle budget
+// or an error bound. Vertices collapse onto one of their neighbours, so the result keeps original
+// positions and normals on the surface; open boundary rings are only shortened along themselves.
+// The quadric cost orders the collapses, the bound is a distance: every surviving vertex stays within
+// it of the planes of all original faces (and boundary planes) around the vertices it replaced.
+// That limits how far vertices leave the surface; on curved parts the Hausdorff distance is larger.
+// Collapses run one at a time in cost order, rotated copies of an edge are not collapsed together.
+class MeshSimplifier
+{
+public:
+    // Statistics of the last run; maxError is the largest plane distance of a collapse, in profile units
+    int inputTriangles = 0;
+    int outputTriangles = 0;
+    int collapses = 0;
+    double maxError = 0.0;
+    double milliseconds = 0.0;
+
+    // targetTriangles <= 0 or errorBound <= 0 (profile units) disables that limit.
+    // Plane, quadric and candidate setup is split across threads for large meshes. The collapse loop
+    // stays serial: every collapse changes the costs of its neighbours, which the next pick depends on.
+    // The editor therefore runs it on the edit worker.
+    bool simplify(const RevolutionMesh& input, RevolutionMesh& output, int targetTriangles, double errorBound);
+
+private:
+    class Candidate
+    {
+    public:
+        double cost;
+        int from, to;
+        int fromStamp, toStamp;
+
+        bool operator<(const Candidate& other) const { return cost > other.cost; }
+    };
+
+    std::vector<float> positions; // xyz per vertex
+    std::vector<unsigned int> faces;
+    std::vector<char> faceRemoved;
+    std::vector<char> vertexRemoved;
+    std::vector<char> boundary;
+    std::vector<int> boundaryEdges; // two vertices and the face of every boundary edge
+    std::vector<int> stamp;
+    std::vector<Quadric> quadrics;
+    std::vector<double> planes; // a, b, c, d of every original face, then of every boundary edge
+    std::vector<std::vector<int>> vertexPlanes; // planes the vertex and the vertices merged into it lie on
+    std::vector<std::vector<int>> vertexFaces;
+    std::vector<Candidate> heap;
+    std::vector<int> scratch;
+    std::vector<int> scratchOther;
+
+    void findBoundary();
+
+    void initQuadrics();
+
+    Candidate candidate(int from, int to) const;
+
+    // Largest distance of to from the planes of both vertices
+    double planeError(int from, int to) const;
+
+    bool canCollapse(int from, int to);
+
+    // Returns the number of faces removed
+    int collapse(int from, int to);
+
+    void neighbours(int v, std::vector<int>& out) const;
+
+    int sharedFaces(int u, int v) const;
+};
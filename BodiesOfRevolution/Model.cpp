@@ -0,0 +1,89 @@
+#include "Model.h"
+#include "GLState.h"
+
+Model::Model(MemorySubsystem subsystem)
+{
+    this->subsystem = subsystem;
+}
+
+Model::~Model()
+{
+    release();
+}
+
+bool Model::create(bool indexed)
+{
+    glGenVertexArrays(1, &this->vao);
+    GLState::bindVertexArray(this->vao);
+
+    glGenBuffers(1, &this->vbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->vbo);
+
+    if (indexed)
+    {
+        glGenBuffers(1, &this->ibo);
+        GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo);
+    }
+
+    return this->vao != 0 && this->vbo != 0 && (!indexed || this->ibo != 0);
+}
+
+void Model::uploadVertices(const void* data, long long bytes, GLenum usage)
+{
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, data, usage);
+
+    MemoryRegistry::addGpuBytes(this->subsystem, bytes - this->vertexCapacity);
+    this->vertexCapacity = this->vertexBytes = bytes;
+}
+
+void Model::uploadIndices(const void* data, long long bytes, GLenum usage)
+{
+    // The element buffer binding belongs to the vertex array
+    GLState::bindVertexArray(this->vao);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes, data, usage);
+
+    MemoryRegistry::addGpuBytes(this->subsystem, bytes - this->indexCapacity);
+    this->indexCapacity = this->indexBytes = bytes;
+}
+
+void Model::allocateVertices(long long bytes, GLenum usage)
+{
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, NULL, usage);
+
+    MemoryRegistry::addGpuBytes(this->subsystem, bytes - this->vertexCapacity);
+    this->vertexCapacity = bytes;
+    this->vertexBytes = 0;
+}
+
+void Model::updateVertices(long long offset, const void* data, long long bytes)
+{
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+
+    if (offset + bytes > this->vertexBytes)
+        this->vertexBytes = offset + bytes;
+}
+
+long long Model::gpuBytes() const
+{
+    return this->vertexCapacity + this->indexCapacity;
+}
+
+void Model::release()
+{
+    if (this->vbo != 0)
+        GLState::deleteBuffer(this->vbo);
+    if (this->ibo != 0)
+        GLState::deleteBuffer(this->ibo);
+    if (this->vao != 0)
+        GLState::deleteVertexArray(this->vao);
+
+    MemoryRegistry::addGpuBytes(this->subsystem, -gpuBytes());
+
+    this->vbo = this->ibo = this->vao = 0;
+    this->indexCount = 0;
+    this->vertexCapacity = this->vertexBytes = this->indexCapacity = this->indexBytes = 0;
+}
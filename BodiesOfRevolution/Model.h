@@ -1,11 +1,47 @@
 #pragma once
 #include <GL/glew.h>
+#include "MemoryRegistry.h"
 
+// Owns a vertex array with its vertex buffer and optional index buffer, and reports the buffer
+// storage to the MemoryRegistry. GL objects must be released with release() while the context
+// is alive; the destructor only catches models that were never released.
 class Model
 {
 public:
-    GLuint vbo;
-    GLuint ibo;
-    GLuint vao;
-    GLsizei indexCount;
+    GLuint vbo = 0;
+    GLuint ibo = 0;
+    GLuint vao = 0;
+    GLsizei indexCount = 0;
+
+    // Allocated buffer storage and the part of it holding data, in bytes
+    long long vertexCapacity = 0;
+    long long vertexBytes = 0;
+    long long indexCapacity = 0;
+    long long indexBytes = 0;
+
+    explicit Model(MemorySubsystem subsystem);
+
+    ~Model();
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // Leaves the vertex array and its buffers bound for the attribute setup
+    bool create(bool indexed);
+
+    void uploadVertices(const void* data, long long bytes, GLenum usage);
+
+    void uploadIndices(const void* data, long long bytes, GLenum usage);
+
+    // Allocates fresh vertex storage without data, the old storage is orphaned
+    void allocateVertices(long long bytes, GLenum usage);
+
+    void updateVertices(long long offset, const void* data, long long bytes);
+
+    long long gpuBytes() const;
+
+    void release();
+
+private:
+    MemorySubsystem subsystem;
 };
@@ -0,0 +1,170 @@
+#include "Overlay.h"
+#include "Tools.h"
+#include "FrameUniforms.h"
+#include "GLState.h"
+
+#define OVERLAY_VERTEX_SIZE 5
+
+bool Overlay::create()
+{
+    if (!createShaderProgram())
+        return false;
+
+    if (!this->model.create(false))
+        return false;
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, OVERLAY_VERTEX_SIZE * sizeof(GLfloat), (const GLvoid*)0);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, OVERLAY_VERTEX_SIZE * sizeof(GLfloat), (const GLvoid*)(2 * sizeof(GLfloat)));
+
+    GLState::bindVertexArray(0);
+
+    return true;
+}
+
+void Overlay::begin()
+{
+    // Capacity is kept between frames, so a steady overlay does not allocate
+    this->triangles.clear();
+    this->lines.clear();
+    this->lineFirst.clear();
+    this->lineCount.clear();
+}
+
+void Overlay::addMarker(Point2D center, float size, float r, float g, float b)
+{
+    double h = size / 2;
+
+    pushVertex(this->triangles, center.x - h, center.y - h, r, g, b);
+    pushVertex(this->triangles, center.x + h, center.y + h, r, g, b);
+    pushVertex(this->triangles, center.x - h, center.y + h, r, g, b);
+    pushVertex(this->triangles, center.x - h, center.y - h, r, g, b);
+    pushVertex(this->triangles, center.x + h, center.y - h, r, g, b);
+    pushVertex(this->triangles, center.x + h, center.y + h, r, g, b);
+}
+
+void Overlay::addPolyline(const Point2D* points, int count, float r, float g, float b)
+{
+    if (count < 2)
+        return;
+
+    // Line vertices are placed after the markers, draw() adds that offset
+    this->lineFirst.push_back(this->lines.size() / OVERLAY_VERTEX_SIZE);
+    this->lineCount.push_back(count);
+
+    for (int i = 0; i < count; i++)
+        pushVertex(this->lines, points[i].x, points[i].y, r, g, b);
+}
+
+void Overlay::draw()
+{
+    int triangleVertices = this->triangles.size() / OVERLAY_VERTEX_SIZE;
+    int lineVertices = this->lines.size() / OVERLAY_VERTEX_SIZE;
+    int total = triangleVertices + lineVertices;
+
+    if (total == 0)
+        return;
+
+    GLState::bindVertexArray(this->model.vao);
+
+    // Orphan the previous frame's storage so the upload does not wait for the GPU
+    long long bytes = total * OVERLAY_VERTEX_SIZE * sizeof(GLfloat);
+    long long capacity = this->model.vertexCapacity;
+    if (bytes > capacity)
+        capacity = bytes + bytes / 2;
+    this->model.allocateVertices(capacity, GL_STREAM_DRAW);
+
+    this->model.updateVertices(0, this->triangles.data(), this->triangles.size() * sizeof(GLfloat));
+    this->model.updateVertices(this->triangles.size() * sizeof(GLfloat), this->lines.data(), this->lines.size() * sizeof(GLfloat));
+
+    GLState::useProgram(this->shaderProgram);
+
+    if (triangleVertices > 0)
+        glDrawArrays(GL_TRIANGLES, 0, triangleVertices);
+
+    if (!this->lineFirst.empty())
+    {
+        for (GLint& first : this->lineFirst)
+            first += triangleVertices;
+
+        glMultiDrawArrays(GL_LINE_STRIP, this->lineFirst.data(), this->lineCount.data(), this->lineFirst.size());
+    }
+}
+
+void Overlay::cleanup()
+{
+    if (this->shaderProgram != 0)
+        GLState::deleteProgram(this->shaderProgram);
+
+    this->model.release();
+}
+
+long long Overlay::memoryBytes() const
+{
+    return vectorBytes(this->triangles) + vectorBytes(this->lines) + vectorBytes(this->lineFirst) + vectorBytes(this->lineCount);
+}
+
+bool Overlay::createShaderProgram()
+{
+    this->shaderProgram = 0;
+
+    const GLchar vsh[] =
+        "#version 330\n"
+        ""
+        "layout(location = 0) in vec2 a_position;"
+        "layout(location = 1) in vec3 a_color;"
+        ""
+        CAMERA_BLOCK
+        ""
+        "out vec3 v_color;"
+        ""
+        "void main()"
+        "{"
+        "    v_color = a_color;"
+        "    gl_Position = u_viewProjection * vec4(a_position, 0.0, 1.0);"
+        "}"
+        ;
+
+    const GLchar fsh[] =
+        "#version 330\n"
+        ""
+        "in vec3 v_color;"
+        ""
+        "layout(location = 0) out vec4 o_color;"
+        ""
+        "void main()"
+        "{"
+        "    o_color = vec4(v_color, 1.0);"
+        "}"
+        ;
+
+    GLuint vertexShader, fragmentShader;
+
+    vertexShader = createShader(vsh, GL_VERTEX_SHADER);
+    fragmentShader = createShader(fsh, GL_FRAGMENT_SHADER);
+
+    if (vertexShader != 0 && fragmentShader != 0)
+        this->shaderProgram = createProgram(vertexShader, fragmentShader);
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    // Compile and link errors are already printed
+    if (this->shaderProgram == 0)
+        return false;
+
+    FrameUniforms::bind(this->shaderProgram);
+
+    return true;
+}
+
+void Overlay::pushVertex(std::vector<GLfloat>& target, double x, double y, float r, float g, float b)
+{
+    target.push_back(x);
+    target.push_back(y);
+    target.push_back(r);
+    target.push_back(g);
+    target.push_back(b);
+}
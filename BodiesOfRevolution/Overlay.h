@@ -0,0 +1,42 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include "tbezier.h"
+#include "Model.h"
+
+// Accumulates the 2D edit-mode geometry (markers and polylines) of a frame and draws it
+// from one streaming buffer with one program: one glDrawArrays for all markers and one
+// glMultiDrawArrays for all polylines.
+class Overlay
+{
+public:
+    GLuint shaderProgram = 0;
+    Model model{ MemorySubsystem::overlay };
+
+    // x, y, r, g, b per vertex
+    std::vector<GLfloat> triangles;
+    std::vector<GLfloat> lines;
+
+    std::vector<GLint> lineFirst;
+    std::vector<GLsizei> lineCount;
+
+    bool create();
+
+    void begin();
+
+    void addMarker(Point2D center, float size, float r, float g, float b);
+
+    void addPolyline(const Point2D* points, int count, float r, float g, float b);
+
+    void draw();
+
+    void cleanup();
+
+    // Capacity of the per-frame vertex arrays, in bytes
+    long long memoryBytes() const;
+
+private:
+    bool createShaderProgram();
+
+    void pushVertex(std::vector<GLfloat>& target, double x, double y, float r, float g, float b);
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <thread>
+#include <vector>
+
+// Splits [0; count) into contiguous chunks of at least minChunk items and runs body(begin, end)
+// for every chunk on its own thread. Small inputs run inline on the calling thread.
+template <typename Body>
+void parallelFor(int count, int minChunk, const Body& body)
+{
+    int threadCount = std::thread::hardware_concurrency();
+    int chunks = (count + minChunk - 1) / (minChunk > 0 ? minChunk : 1);
+
+    if (threadCount < 1)
+        threadCount = 1;
+    if (chunks > threadCount)
+        chunks = threadCount;
+
+    if (chunks <= 1)
+    {
+        body(0, count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+
+    for (int c = 1; c < chunks; c++)
+    {
+        int begin = (int)((long long)count * c / chunks);
+        int end = (int)((long long)count * (c + 1) / chunks);
+        threads.emplace_back([&body, begin, end]() { body(begin, end); });
+    }
+
+    body(0, (int)((long long)count / chunks));
+
+    for (std::thread& thread : threads)
+        thread.join();
+}
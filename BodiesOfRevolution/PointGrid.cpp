@@ -0,0 +1,76 @@
+#include "PointGrid.h"
+#include "MemoryRegistry.h"
+
+PointGrid::PointGrid()
+{
+    this->head.assign(GRID_BUCKETS, -1);
+}
+
+long long PointGrid::memoryBytes() const
+{
+    return vectorBytes(this->head) + vectorBytes(this->next);
+}
+
+void PointGrid::clear()
+{
+    this->head.assign(GRID_BUCKETS, -1);
+    this->next.clear();
+}
+
+void PointGrid::insert(int index, const Point2D& p)
+{
+    if (index >= (int)this->next.size())
+        this->next.resize(index + 1, -1);
+
+    int& first = this->head[bucket(cell(p.x), cell(p.y))];
+    this->next[index] = first;
+    first = index;
+}
+
+void PointGrid::remove(int index, const Point2D& p)
+{
+    int* link = &this->head[bucket(cell(p.x), cell(p.y))];
+
+    while (*link >= 0)
+    {
+        if (*link == index)
+        {
+            *link = this->next[index];
+            return;
+        }
+        link = &this->next[*link];
+    }
+}
+
+int PointGrid::nearest(const std::vector<Point2D>& points, const Point2D& p, double radius) const
+{
+    int result = -1;
+    double best = radius * radius;
+
+    // Points of other cells that share a bucket are rejected by the distance test
+    for (int cx = cell(p.x - radius); cx <= cell(p.x + radius); cx++)
+        for (int cy = cell(p.y - radius); cy <= cell(p.y + radius); cy++)
+            for (int index = this->head[bucket(cx, cy)]; index >= 0; index = this->next[index])
+            {
+                Point2D d = points[index] - p;
+                double distance = d.x * d.x + d.y * d.y;
+                if (distance <= best)
+                {
+                    best = distance;
+                    result = index;
+                }
+            }
+
+    return result;
+}
+
+int PointGrid::cell(double v) const
+{
+    return (int)floor(v / this->cellSize);
+}
+
+int PointGrid::bucket(int cx, int cy) const
+{
+    unsigned int h = (unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u;
+    return h % GRID_BUCKETS;
+}
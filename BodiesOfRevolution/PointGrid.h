@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "tbezier.h"
+
+#define GRID_BUCKETS 1024
+
+// Uniform hash grid over control points for constant time hit testing. Cells are hashed into
+// a fixed bucket table with intrusive lists, so moving a point never allocates.
+class PointGrid
+{
+public:
+    double cellSize = 16.0;
+
+    PointGrid();
+
+    void clear();
+
+    void insert(int index, const Point2D& p);
+
+    void remove(int index, const Point2D& p);
+
+    int nearest(const std::vector<Point2D>& points, const Point2D& p, double radius) const;
+
+    long long memoryBytes() const;
+
+private:
+    std::vector<int> head; // first point of every bucket, -1 when empty
+    std::vector<int> next; // next point in the same bucket, indexed by point
+
+    int cell(double v) const;
+
+    int bucket(int cx, int cy) const;
+};
@@ -1,16 +1,4 @@
 #include "Points.h"
-#include "Tools.h"
-
-void Points::updateBuffers()
-{
-    glBindBuffer(GL_ARRAY_BUFFER, this->model.vbo);
-    glBufferData(GL_ARRAY_BUFFER, this->points.size() * sizeof(GLfloat), this->points.data(), GL_DYNAMIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->model.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLint), this->indices.data(), GL_DYNAMIC_DRAW);
-
-    this->model.indexCount = indices.size();
-}
 
 void Points::add(Vector2 point)
 {
@@ -18,120 +6,50 @@ void Points::add(Vector2 point)
         this->pointCenters.push_back(element);
 
     this->point2DCenters.push_back(Point2D(point[0], point[1]));
+    this->grid.insert(this->numberOfPoints, this->point2DCenters.back());
 
-    float x = point[0], y = point[1];
-
-    this->points.push_back(x - sideLength / 2), this->points.push_back(y - sideLength / 2);
-    this->points.push_back(x + sideLength / 2), this->points.push_back(y + sideLength / 2);
-    this->points.push_back(x - sideLength / 2), this->points.push_back(y + sideLength / 2);
-    this->points.push_back(x + sideLength / 2), this->points.push_back(y - sideLength / 2);
-
-    indices.push_back(this->numberOfDots);
-    indices.push_back(this->numberOfDots + 1);
-    indices.push_back(this->numberOfDots + 2);
-    indices.push_back(this->numberOfDots);
-    indices.push_back(this->numberOfDots + 3);
-    indices.push_back(this->numberOfDots + 1);
-
-    this->numberOfDots += 4;
     this->numberOfPoints++;
 
-    updateBuffers();
+    this->dirty = true;
 }
 
 void Points::pop()
 {
-    this->points.erase(this->points.end() - 8, this->points.end());
-    this->indices.erase(this->indices.end() - 6, this->indices.end());
-    this->point2DCenters.erase(this->point2DCenters.end() - 1, this->point2DCenters.end());
-    this->numberOfDots -= 4;
+    this->grid.remove(this->numberOfPoints - 1, this->point2DCenters.back());
+
+    this->pointCenters.resize(this->pointCenters.size() - 2);
+    this->point2DCenters.pop_back();
     this->numberOfPoints--;
 
-    updateBuffers();
+    this->dirty = true;
 }
 
-bool Points::createModel()
+int Points::pick(Vector2 point)
 {
-    glGenVertexArrays(1, &this->model.vao);
-    glBindVertexArray(this->model.vao);
-
-    glGenBuffers(1, &this->model.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, this->model.vbo);
-
-    glGenBuffers(1, &this->model.ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->model.ibo);
-
-    this->model.indexCount = indices.size();
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (const GLvoid*)0);
-
-    return this->model.vbo != 0 && this->model.ibo != 0 && this->model.vao != 0;
+    return this->grid.nearest(this->point2DCenters, Point2D(point[0], point[1]), sideLength);
 }
 
-bool Points::createShaderProgram()
+void Points::move(int index, Vector2 point)
 {
-    this->shaderProgram = 0;
-
-    const GLchar vsh[] =
-        "#version 330\n"
-        ""
-        "layout(location = 0) in vec2 a_position;"
-        ""
-        "uniform mat4 u_mvp;"
-        ""
-        "void main()"
-        "{"
-        "    gl_Position = u_mvp * vec4(a_position, 0.0, 1.0);"
-        "}"
-        ;
-
-    const GLchar fsh[] =
-        "#version 330\n"
-        ""
-        "layout(location = 0) out vec4 o_color;"
-        ""
-        "void main()"
-        "{"
-        "    o_color = vec4(1.0, 0.0, 0.0, 1.0);"
-        "}"
-        ;
-
-    GLuint vertexShader, fragmentShader;
-
-    vertexShader = createShader(vsh, GL_VERTEX_SHADER);
-    fragmentShader = createShader(fsh, GL_FRAGMENT_SHADER);
-
-    this->shaderProgram = createProgram(vertexShader, fragmentShader);
+    float x = point[0], y = point[1];
 
-    this->uMVP = glGetUniformLocation(this->shaderProgram, "u_mvp");
+    this->grid.remove(index, this->point2DCenters[index]);
+    this->point2DCenters[index] = Point2D(x, y);
+    this->grid.insert(index, this->point2DCenters[index]);
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    this->pointCenters[2 * index] = x;
+    this->pointCenters[2 * index + 1] = y;
 
-    return this->shaderProgram != 0;
+    this->dirty = true;
 }
 
-void Points::draw(double deltaTime, Matrix4& lookAt, Matrix4& perspective)
+void Points::addToOverlay(Overlay& overlay)
 {
-    glUseProgram(this->shaderProgram);
-    glBindVertexArray(this->model.vao);
-
-    Matrix4 s_umv = perspective * lookAt;
-
-    glUniformMatrix4fv(this->uMVP, 1, GL_TRUE, s_umv.elements);
-
-    glDrawElements(GL_TRIANGLES, this->model.indexCount, GL_UNSIGNED_INT, NULL);
+    for (const Point2D& center : this->point2DCenters)
+        overlay.addMarker(center, this->sideLength, 1.0f, 0.0f, 0.0f);
 }
 
-void Points::cleanup()
+long long Points::memoryBytes() const
 {
-    if (this->shaderProgram != 0)
-        glDeleteProgram(this->shaderProgram);
-    if (this->model.vbo != 0)
-        glDeleteBuffers(1, &this->model.vbo);
-    if (this->model.ibo != 0)
-        glDeleteBuffers(1, &this->model.ibo);
-    if (this->model.vao != 0)
-        glDeleteVertexArrays(1, &this->model.vao);
+    return vectorBytes(this->pointCenters) + vectorBytes(this->point2DCenters) + this->grid.memoryBytes();
 }
@@ -1,41 +1,34 @@
 #pragma once
-#include <GL/glew.h>
-#include "Model.h"
 #include <vector>
 #include "tbezier.h"
 #include "Vector.h"
-#include "Matrix.h"
+#include "Overlay.h"
+#include "PointGrid.h"
 
 class Points
 {
 public:
-    Model model;
-    GLuint shaderProgram;
-    GLint uMVP;
-
     std::vector<GLfloat> pointCenters; //  
 
     std::vector<Point2D> point2DCenters; //  ,    Point2D(x, y)
 
-    std::vector<GLfloat> points; //   , ..    
-
-    std::vector<GLint> indices; //     
-
     float sideLength = 7.5f;
-    int numberOfDots = 0;
     int numberOfPoints = 0;
 
-    void updateBuffers();
+    PointGrid grid;
+
+    // Set on every change of the points, cleared by the main loop once the change is on screen
+    bool dirty = true;
 
     void add(Vector2 point);
 
     void pop();
 
-    bool createModel();
+    int pick(Vector2 point);
 
-    bool createShaderProgram();
+    void move(int index, Vector2 point);
 
-    void draw(double deltaTime, Matrix4& lookAt, Matrix4& perspective);
+    void addToOverlay(Overlay& overlay);
 
-    void cleanup();
+    long long memoryBytes() const;
 };
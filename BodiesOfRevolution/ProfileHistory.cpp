@@ -0,0 +1,192 @@
+#include "ProfileHistory.h"
+#include "MemoryRegistry.h"
+#include <algorithm>
+
+void ProfileState::copyTo(std::vector<Point2D>& profile) const
+{
+    profile.resize(this->count);
+
+    for (int i = 0; i < this->count; i++)
+        profile[i] = this->chunks[i / HISTORY_CHUNK]->points[i % HISTORY_CHUNK];
+}
+
+ProfileHistory::ProfileHistory()
+{
+    // The history starts with the empty profile
+    this->states.push_back(std::make_shared<ProfileState>());
+}
+
+bool ProfileHistory::checkpoint(const std::vector<Point2D>& profile)
+{
+    const ProfileState& previous = current();
+
+    auto state = std::make_shared<ProfileState>();
+    state->count = profile.size();
+
+    bool changed = state->count != previous.count;
+
+    for (int first = 0; first < state->count; first += HISTORY_CHUNK)
+    {
+        int c = first / HISTORY_CHUNK;
+        int count = std::min(HISTORY_CHUNK, state->count - first);
+
+        // A chunk of the previous state is reused when it holds the same points
+        if (c < (int)previous.chunks.size() && previous.chunks[c]->count >= count)
+        {
+            const ProfileChunk& chunk = *previous.chunks[c];
+
+            bool equal = true;
+            for (int i = 0; i < count && equal; i++)
+                equal = chunk.points[i].x == profile[first + i].x && chunk.points[i].y == profile[first + i].y;
+
+            if (equal)
+            {
+                state->chunks.push_back(previous.chunks[c]);
+                continue;
+            }
+        }
+
+        auto chunk = std::make_shared<ProfileChunk>();
+        std::copy(profile.begin() + first, profile.begin() + first + count, chunk->points);
+        chunk->count = count;
+
+        state->chunks.push_back(chunk);
+        changed = true;
+    }
+
+    if (!changed)
+        return false;
+
+    state->id = this->nextId++;
+
+    this->states.resize(this->index + 1);
+    this->states.push_back(state);
+
+    if ((int)this->states.size() > HISTORY_MAX_STATES)
+        this->states.erase(this->states.begin());
+
+    this->index = this->states.size() - 1;
+
+    return true;
+}
+
+const ProfileState* ProfileHistory::undo()
+{
+    if (this->index == 0)
+        return NULL;
+
+    return this->states[--this->index].get();
+}
+
+const ProfileState* ProfileHistory::redo()
+{
+    if (this->index + 1 >= (int)this->states.size())
+        return NULL;
+
+    return this->states[++this->index].get();
+}
+
+const ProfileState& ProfileHistory::current() const
+{
+    return *this->states[this->index];
+}
+
+long long ProfileHistory::memoryBytes() const
+{
+    this->scratch.clear();
+    for (const auto& state : this->states)
+        for (const auto& chunk : state->chunks)
+            this->scratch.push_back(chunk.get());
+
+    std::sort(this->scratch.begin(), this->scratch.end());
+    long long chunks = std::unique(this->scratch.begin(), this->scratch.end()) - this->scratch.begin();
+
+    long long result = vectorBytes(this->states) + vectorBytes(this->scratch) + chunks * sizeof(ProfileChunk);
+    for (const auto& state : this->states)
+        result += sizeof(ProfileState) + vectorBytes(state->chunks);
+
+    return result;
+}
+
+std::shared_ptr<const Curve> GeometryCache::findCurve(unsigned long long state)
+{
+    const Entry* entry = find(key(state, 0));
+    return entry != NULL ? entry->curve : NULL;
+}
+
+void GeometryCache::putCurve(unsigned long long state, const Curve& curve)
+{
+    Entry entry;
+    entry.key = key(state, 0);
+    entry.curve = std::make_shared<Curve>(curve);
+    entry.bytes = sizeof(Curve) + curve.memoryBytes();
+
+    put(entry);
+}
+
+std::shared_ptr<const RevolutionMesh> GeometryCache::findMesh(unsigned long long state, int revolutions)
+{
+    const Entry* entry = find(key(state, revolutions));
+    return entry != NULL ? entry->mesh : NULL;
+}
+
+void GeometryCache::putMesh(unsigned long long state, int revolutions, const RevolutionMesh& mesh)
+{
+    Entry entry;
+    entry.key = key(state, revolutions);
+    entry.mesh = std::make_shared<RevolutionMesh>(mesh);
+    entry.bytes = sizeof(RevolutionMesh) + mesh.memoryBytes();
+
+    put(entry);
+}
+
+long long GeometryCache::memoryBytes() const
+{
+    // List and hash nodes are small next to the geometry and left out
+    return this->bytes;
+}
+
+unsigned long long GeometryCache::key(unsigned long long state, int revolutions)
+{
+    return state << 16 | (unsigned long long)(revolutions & 0xFFFF);
+}
+
+const GeometryCache::Entry* GeometryCache::find(unsigned long long key)
+{
+    auto found = this->index.find(key);
+    if (found == this->index.end())
+    {
+        this->misses++;
+        return NULL;
+    }
+
+    // Move to the front
+    this->entries.splice(this->entries.begin(), this->entries, found->second);
+    this->hits++;
+
+    return &*found->second;
+}
+
+void GeometryCache::put(Entry entry)
+{
+    auto found = this->index.find(entry.key);
+    if (found != this->index.end())
+    {
+        this->bytes -= found->second->bytes;
+        this->entries.erase(found->second);
+        this->index.erase(found);
+    }
+
+    this->bytes += entry.bytes;
+    this->entries.push_front(entry);
+    this->index[entry.key] = this->entries.begin();
+
+    // The newest entry is kept even if it alone exceeds the cap
+    while (this->bytes > this->maxBytes && this->entries.size() > 1)
+    {
+        Entry& last = this->entries.back();
+        this->bytes -= last.bytes;
+        this->index.erase(last.key);
+        this->entries.pop_back();
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "tbezier.h"
+#include "Curve.h"
+#include "RevolutionMesh.h"
+
+// Control points per shared chunk of a profile state
+#define HISTORY_CHUNK 32
+
+// Oldest states are dropped beyond this many
+#define HISTORY_MAX_STATES 256
+
+// Memory cap of the cached curves and meshes
+#define GEOMETRY_CACHE_BYTES (64LL << 20)
+
+class ProfileChunk
+{
+public:
+    Point2D points[HISTORY_CHUNK];
+    int count = 0;
+};
+
+// Immutable snapshot of the control points. Consecutive states share every chunk that did not
+// change, so moving one point or adding one at the end copies a single chunk.
+class ProfileState
+{
+public:
+    unsigned long long id = 0;
+    int count = 0;
+    std::vector<std::shared_ptr<const ProfileChunk>> chunks;
+
+    void copyTo(std::vector<Point2D>& profile) const;
+};
+
+// Undo/redo stack of profile states. Edit worker only.
+class ProfileHistory
+{
+public:
+    ProfileHistory();
+
+    // Records the profile as a new state unless it equals the current one, drops the redo states
+    bool checkpoint(const std::vector<Point2D>& profile);
+
+    // Step through the history, NULL at either end
+    const ProfileState* undo();
+
+    const ProfileState* redo();
+
+    const ProfileState& current() const;
+
+    // Chunks shared by several states are counted once
+    long long memoryBytes() const;
+
+private:
+    std::vector<std::shared_ptr<const ProfileState>> states;
+    int index = 0;
+    unsigned long long nextId = 1;
+
+    mutable std::vector<const ProfileChunk*> scratch;
+};
+
+// Least recently used cache of the curves and body meshes derived from profile states, so that
+// stepping through the history does not recompute them. Edit worker only.
+class GeometryCache
+{
+public:
+    long long maxBytes = GEOMETRY_CACHE_BYTES;
+
+    std::shared_ptr<const Curve> findCurve(unsigned long long state);
+
+    void putCurve(unsigned long long state, const Curve& curve);
+
+    std::shared_ptr<const RevolutionMesh> findMesh(unsigned long long state, int revolutions);
+
+    void putMesh(unsigned long long state, int revolutions, const RevolutionMesh& mesh);
+
+    long long memoryBytes() const;
+
+    // Statistics
+    int hits = 0;
+    int misses = 0;
+
+private:
+    class Entry
+    {
+    public:
+        unsigned long long key;
+        std::shared_ptr<const Curve> curve;
+        std::shared_ptr<const RevolutionMesh> mesh;
+        long long bytes;
+    };
+
+    // Most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<unsigned long long, std::list<Entry>::iterator> index;
+    long long bytes = 0;
+
+    // Curves use revolutions 0
+    static unsigned long long key(unsigned long long state, int revolutions);
+
+    const Entry* find(unsigned long long key);
+
+    void put(Entry entry);
+};
@@ -0,0 +1,313 @@
+#include "RayCaster.h"
+#include "Parallel.h"
+#include "Tools.h"
+#include <algorithm>
+
+// The ray against a segment is a polynomial in the curve parameter of at most this degree
+#define RAY_DEGREE 6
+#define RAY_BISECTIONS 52
+
+// Power basis coefficients c[0] + c[1] u + c[2] u^2 + c[3] u^3 of a cubic Bezier coordinate
+static void powerBasis(double p0, double p1, double p2, double p3, double c[4])
+{
+    c[0] = p0;
+    c[1] = 3.0 * (p1 - p0);
+    c[2] = 3.0 * (p0 - 2.0 * p1 + p2);
+    c[3] = p3 - p0 + 3.0 * (p1 - p2);
+}
+
+static double evaluatePolynomial(const double* c, int degree, double u)
+{
+    double result = c[degree];
+    for (int i = degree - 1; i >= 0; i--)
+        result = result * u + c[i];
+    return result;
+}
+
+// Roots in [0, 1] in ascending order. The roots of the derivative split [0, 1] into monotonic
+// pieces holding at most one root each, which is bracketed and bisected. Extrema that touch zero
+// are roots too, so grazing hits and close pairs of crossings are not lost.
+static int polynomialRoots(const double* c, int degree, double* roots)
+{
+    if (degree <= 0)
+        return 0;
+
+    if (degree == 1)
+    {
+        if (c[1] == 0.0)
+            return 0;
+
+        double u = -c[0] / c[1];
+        if (u < 0.0 || u > 1.0)
+            return 0;
+
+        roots[0] = u;
+        return 1;
+    }
+
+    double derivative[RAY_DEGREE];
+    for (int i = 0; i < degree; i++)
+        derivative[i] = (i + 1) * c[i + 1];
+
+    double breaks[RAY_DEGREE + 1], values[RAY_DEGREE + 1];
+    int count = 1 + polynomialRoots(derivative, degree - 1, breaks + 1);
+    breaks[0] = 0.0;
+    breaks[count++] = 1.0;
+
+    double scale = 0.0;
+    for (int i = 0; i <= degree; i++)
+        scale += fabs(c[i]);
+    double tolerance = 1.0e-12 * scale;
+
+    for (int i = 0; i < count; i++)
+        values[i] = evaluatePolynomial(c, degree, breaks[i]);
+
+    // A polynomial that is zero within the tolerance everywhere stops at degree roots
+    int result = 0;
+    for (int i = 0; i < count && result < degree; i++)
+    {
+        if (fabs(values[i]) <= tolerance)
+        {
+            roots[result++] = breaks[i];
+            continue;
+        }
+
+        if (i + 1 == count || fabs(values[i + 1]) <= tolerance || (values[i] < 0.0) == (values[i + 1] < 0.0))
+            continue;
+
+        double lo = breaks[i], hi = breaks[i + 1];
+        bool negative = values[i] < 0.0;
+        for (int k = 0; k < RAY_BISECTIONS && lo < hi; k++)
+        {
+            double mid = 0.5 * (lo + hi);
+            if ((evaluatePolynomial(c, degree, mid) < 0.0) == negative)
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        roots[result++] = 0.5 * (lo + hi);
+    }
+
+    return result;
+}
+
+void RayCaster::build(const std::vector<Segment>& segments, Matrix4& model)
+{
+    this->segments = segments;
+    this->bounds.resize(segments.size());
+
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        // The curve lies inside the convex hull of its control points
+        Bounds& b = this->bounds[i];
+        b.minX = b.maxX = segments[i].points[0].x;
+        b.minR = b.maxR = fabs(segments[i].points[0].y);
+
+        double minY = segments[i].points[0].y, maxY = minY;
+
+        for (int j = 1; j < 4; j++)
+        {
+            const Point2D& p = segments[i].points[j];
+            b.minX = p.x < b.minX ? p.x : b.minX;
+            b.maxX = p.x > b.maxX ? p.x : b.maxX;
+            minY = p.y < minY ? p.y : minY;
+            maxY = p.y > maxY ? p.y : maxY;
+        }
+
+        b.maxR = fabs(minY) > fabs(maxY) ? fabs(minY) : fabs(maxY);
+        b.minR = minY > 0.0 ? minY : (maxY < 0.0 ? -maxY : 0.0);
+    }
+
+    double m[16];
+    for (int i = 0; i < 16; i++)
+        m[i] = model.elements[i];
+
+    invertAffine(m, this->inverse);
+}
+
+RayHit RayCaster::intersect(const Ray& ray) const
+{
+    RayHit hit;
+
+    double worldOrigin[3], worldDirection[3];
+    for (int i = 0; i < 3; i++)
+    {
+        worldOrigin[i] = ray.origin.elements[i];
+        worldDirection[i] = ray.direction.elements[i];
+    }
+
+    double length = sqrt(worldDirection[0] * worldDirection[0] + worldDirection[1] * worldDirection[1] + worldDirection[2] * worldDirection[2]);
+    if (IS_ZERO(length))
+        return hit;
+
+    for (int i = 0; i < 3; i++)
+        worldDirection[i] /= length;
+
+    // The ray parameter is preserved by the affine transform, so t stays a world space distance
+    double o[3], d[3];
+    transformPoint(this->inverse, worldOrigin, o);
+    transformDirection(this->inverse, worldDirection, d);
+
+    double bestT = INFINITY, bestU = 0.0;
+    int bestSegment = -1;
+
+    for (int i = 0; i < (int)this->segments.size(); i++)
+        if (intersectSegment(i, o, d, bestT, bestU))
+            bestSegment = i;
+
+    if (bestSegment < 0)
+        return hit;
+
+    double p[3], n[3], worldNormal[3];
+    for (int i = 0; i < 3; i++)
+        p[i] = o[i] + bestT * d[i];
+
+    // Profile normal turned around the axis into the meridian plane of the hit point
+    Point2D tangent = this->segments[bestSegment].tangent(bestU);
+    double r = sqrt(p[1] * p[1] + p[2] * p[2]);
+
+    n[0] = -tangent.y;
+    n[1] = IS_ZERO(r) ? 0.0 : tangent.x * p[1] / r;
+    n[2] = IS_ZERO(r) ? 0.0 : tangent.x * p[2] / r;
+
+    // Normals go through the inverse transpose of the model matrix
+    for (int i = 0; i < 3; i++)
+        worldNormal[i] = this->inverse[i] * n[0] + this->inverse[4 + i] * n[1] + this->inverse[8 + i] * n[2];
+
+    double normalLength = sqrt(worldNormal[0] * worldNormal[0] + worldNormal[1] * worldNormal[1] + worldNormal[2] * worldNormal[2]);
+
+    hit.hit = true;
+    hit.segment = bestSegment;
+    hit.u = bestU;
+    hit.distance = bestT;
+    for (int i = 0; i < 3; i++)
+    {
+        hit.point[i] = worldOrigin[i] + bestT * worldDirection[i];
+        hit.normal[i] = IS_ZERO(normalLength) ? 0.0 : worldNormal[i] / normalLength;
+    }
+
+    return hit;
+}
+
+void RayCaster::intersect(const std::vector<Ray>& rays, std::vector<RayHit>& hits) const
+{
+    hits.resize(rays.size());
+
+    parallelFor((int)rays.size(), 256, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+            hits[i] = intersect(rays[i]);
+    });
+}
+
+bool RayCaster::intersectSegment(int index, const double o[3], const double d[3], double& bestT, double& bestU) const
+{
+    const Bounds& b = this->bounds[index];
+    const Segment& segment = this->segments[index];
+
+    // Squared distance to the axis along the ray: r^2(t) = A t^2 + B t + R
+    double A = d[1] * d[1] + d[2] * d[2];
+    double B = 2.0 * (o[1] * d[1] + o[2] * d[2]);
+    double R = o[1] * o[1] + o[2] * o[2];
+
+    bool axial = !IS_ZERO(d[0]);
+
+    // Ray interval inside the slab of the segment bounds along the axis
+    double t0 = 0.0, t1 = bestT;
+    if (axial)
+    {
+        double ta = (b.minX - o[0]) / d[0];
+        double tb = (b.maxX - o[0]) / d[0];
+        if (ta > tb)
+            std::swap(ta, tb);
+        t0 = ta > t0 ? ta : t0;
+        t1 = tb < t1 ? tb : t1;
+    }
+    else if (o[0] < b.minX || o[0] > b.maxX)
+        return false;
+
+    if (t0 > t1)
+        return false;
+
+    // Reject the segment when the radius range of the ray there misses the bounds
+    if (t1 < INFINITY)
+    {
+        double tv = IS_ZERO(A) ? t0 : -B / (2.0 * A);
+        tv = tv < t0 ? t0 : (tv > t1 ? t1 : tv);
+
+        double r2min = (A * tv + B) * tv + R;
+        double r2max = std::max((A * t0 + B) * t0 + R, (A * t1 + B) * t1 + R);
+
+        if (r2min > b.maxR * b.maxR || r2max < b.minR * b.minR)
+            return false;
+    }
+
+    // For rays along the axis direction every curve point maps to one ray parameter t(u), and the
+    // hits are the roots of y(u)^2 - r^2(t(u)), of degree 6. Rays perpendicular to the axis cross
+    // a constant x instead, the roots of the cubic x(u) - o.x.
+    const Point2D* p = segment.points;
+    double cx[4], cy[4], f[RAY_DEGREE + 1] = { 0.0 };
+    powerBasis(p[0].x, p[1].x, p[2].x, p[3].x, cx);
+    powerBasis(p[0].y, p[1].y, p[2].y, p[3].y, cy);
+
+    int degree = 3;
+    if (axial)
+    {
+        double ct[4] = { (cx[0] - o[0]) / d[0], cx[1] / d[0], cx[2] / d[0], cx[3] / d[0] };
+
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                f[i + j] += cy[i] * cy[j] - A * ct[i] * ct[j];
+
+        for (int i = 0; i < 4; i++)
+            f[i] -= B * ct[i];
+        f[0] -= R;
+
+        degree = 6;
+    }
+    else
+    {
+        for (int i = 0; i < 4; i++)
+            f[i] = cx[i];
+        f[0] -= o[0];
+    }
+
+    auto parameter = [&](double u, double& t) -> bool
+    {
+        Point2D p = segment.calc(u);
+        if (axial)
+        {
+            t = (p.x - o[0]) / d[0];
+            return t >= 0.0;
+        }
+
+        // Nearest non-negative root of A t^2 + B t + R = y^2
+        double c = R - p.y * p.y;
+        double discriminant = B * B - 4.0 * A * c;
+        if (IS_ZERO(A) || discriminant < 0.0)
+            return false;
+
+        double s = sqrt(discriminant);
+        double ta = (-B - s) / (2.0 * A), tb = (-B + s) / (2.0 * A);
+        t = ta >= 0.0 ? ta : tb;
+        return t >= 0.0;
+    };
+
+    bool found = false;
+    double roots[RAY_DEGREE];
+    int count = polynomialRoots(f, degree, roots);
+
+    for (int i = 0; i < count; i++)
+    {
+        double t;
+        if (parameter(roots[i], t) && t < bestT)
+        {
+            bestT = t;
+            bestU = roots[i];
+            found = true;
+        }
+    }
+
+    return found;
+}
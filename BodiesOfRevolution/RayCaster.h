@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include "tbezier.h"
+#include "Matrix.h"
+
+class Ray
+{
+public:
+    Vector3 origin;
+    Vector3 direction;
+};
+
+class RayHit
+{
+public:
+    bool hit = false;
+
+    Vector3 point;  // world space
+    Vector3 normal; // world space, unit length
+
+    int segment = -1;   // index of the profile segment that was hit
+    double u = 0.0;     // curve parameter inside the segment
+    double distance = 0.0;
+};
+
+// Intersects rays with a body of revolution directly in profile space: the ray is moved into the
+// meridian half-plane, where it becomes a hyperbola r^2(x), and is solved against the Bezier segments.
+class RayCaster
+{
+public:
+    void build(const std::vector<Segment>& segments, Matrix4& model);
+
+    RayHit intersect(const Ray& ray) const;
+
+    void intersect(const std::vector<Ray>& rays, std::vector<RayHit>& hits) const;
+
+private:
+    class Bounds
+    {
+    public:
+        double minX, maxX, minR, maxR;
+    };
+
+    std::vector<Segment> segments;
+    std::vector<Bounds> bounds;
+
+    double inverse[16];
+
+    bool intersectSegment(int index, const double o[3], const double d[3], double& bestT, double& bestU) const;
+};
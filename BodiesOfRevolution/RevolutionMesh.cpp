@@ -0,0 +1,122 @@
+#include "RevolutionMesh.h"
+#include "MemoryRegistry.h"
+#include "MeshKernels.h"
+
+bool RevolutionMesh::build(const std::vector<Point2D>& points, const std::vector<Point2D>& tangents, int revolutions)
+{
+    const int n = points.size();
+
+    this->vertices.clear();
+    this->indices.clear();
+    this->base.resize(n);
+    this->pole.resize(n);
+    this->revolutions = revolutions;
+    this->poleCount = 0;
+
+    if (n < 2 || tangents.size() != points.size() || revolutions < 3)
+        return false;
+
+    unsigned int vertexCount = 0;
+
+    for (int k = 0; k < n; k++)
+    {
+        this->pole[k] = fabs(points[k].y) < POLE_TOLERANCE;
+        this->base[k] = vertexCount;
+
+        if (this->pole[k])
+        {
+            this->poleCount++;
+            vertexCount += 1;
+        }
+        else
+            vertexCount += revolutions;
+    }
+
+    // Rings are written in place by the kernel specialized for this revolution count, if any
+    RevolveKernel revolve = findRevolveKernel(revolutions);
+
+    this->vertices.resize(vertexCount * 6);
+    float* out = this->vertices.data();
+
+    for (int k = 0; k < n; k++)
+    {
+        // Profile normal is the tangent turned by 90 degrees
+        float nx = -tangents[k].y;
+        float ny = tangents[k].x;
+
+        if (this->pole[k])
+        {
+            // All rotated normals average out to the axis direction at a pole
+            out[0] = points[k].x;
+            out[1] = out[2] = 0.0f;
+            out[3] = nx < 0.0f ? -1.0f : 1.0f;
+            out[4] = out[5] = 0.0f;
+            out += 6;
+            continue;
+        }
+
+        if (revolve != NULL)
+            revolve(points[k].x, points[k].y, nx, ny, out);
+        else
+            revolveGeneric(points[k].x, points[k].y, nx, ny, revolutions, out);
+
+        out += revolutions * 6;
+    }
+
+    this->indices.reserve((n - 1) * revolutions * 6);
+
+    for (int k = 0; k < n - 1; k++)
+    {
+        // Two poles in a row lie on the axis and produce no surface
+        if (this->pole[k] && this->pole[k + 1])
+            continue;
+
+        for (int r = 0; r < revolutions; r++)
+        {
+            unsigned int a = vertexIndex(k, r);
+            unsigned int b = vertexIndex(k, r + 1);
+            unsigned int c = vertexIndex(k + 1, r);
+            unsigned int d = vertexIndex(k + 1, r + 1);
+
+            // Next to a pole one triangle of the quad collapses, the other one forms the fan
+            if (a != b)
+            {
+                this->indices.push_back(a);
+                this->indices.push_back(b);
+                this->indices.push_back(c);
+            }
+            if (c != d)
+            {
+                this->indices.push_back(b);
+                this->indices.push_back(d);
+                this->indices.push_back(c);
+            }
+        }
+    }
+
+    return true;
+}
+
+int RevolutionMesh::vertexCount() const
+{
+    return this->vertices.size() / 6;
+}
+
+int RevolutionMesh::triangleCount() const
+{
+    return this->indices.size() / 3;
+}
+
+long long RevolutionMesh::memoryBytes() const
+{
+    // vector<bool> packs its flags into bits
+    return vectorBytes(this->vertices) + vectorBytes(this->indices) + vectorBytes(this->base) + this->pole.capacity() / 8;
+}
+
+unsigned int RevolutionMesh::vertexIndex(int k, int r) const
+{
+    if (this->pole[k])
+        return this->base[k];
+
+    return this->base[k] + r % this->revolutions;
+}
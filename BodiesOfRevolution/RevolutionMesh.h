@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "tbezier.h"
+
+// Profile points closer than this to the rotation axis are welded into a single pole vertex.
+// Profile units are screen pixels, so this also snaps clicks on the bottom row of the window.
+#define POLE_TOLERANCE 1.5
+
+class RevolutionMesh
+{
+public:
+    std::vector<float> vertices; // position and normal, 6 floats per vertex
+
+    std::vector<unsigned int> indices;
+
+    int revolutions = 0;
+    int poleCount = 0;
+
+    bool build(const std::vector<Point2D>& points, const std::vector<Point2D>& tangents, int revolutions);
+
+    int vertexCount() const;
+
+    int triangleCount() const;
+
+    long long memoryBytes() const;
+
+private:
+    std::vector<unsigned int> base; // index of the first vertex of every profile point
+
+    std::vector<bool> pole;
+
+    unsigned int vertexIndex(int k, int r) const;
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include <math.h>
+#include <string.h>
+#include "Vector.h"
+
+// In-tree 4x4 float math for per-frame matrices and batch point transforms. Everything is
+// inline so the compiler can see through it, with an SSE path and a scalar fallback.
+// Matrices are row-major like Matrix4::elements and are uploaded with transpose = GL_TRUE.
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SIMD_MATH_SSE
+#endif
+
+class Vec4f
+{
+public:
+    alignas(16) float v[4];
+
+    Vec4f()
+    {
+        v[0] = v[1] = v[2] = v[3] = 0.0f;
+    }
+
+    Vec4f(float x, float y, float z, float w)
+    {
+        v[0] = x, v[1] = y, v[2] = z, v[3] = w;
+    }
+
+    float& operator[](int i) { return v[i]; }
+    float operator[](int i) const { return v[i]; }
+};
+
+class Mat4f
+{
+public:
+    alignas(16) float m[16];
+
+    Mat4f()
+    {
+        memset(m, 0, sizeof(m));
+        m[0] = m[5] = m[10] = m[15] = 1.0f;
+    }
+
+    explicit Mat4f(const float elements[16])
+    {
+        memcpy(m, elements, sizeof(m));
+    }
+
+    float& operator()(int row, int column) { return m[4 * row + column]; }
+    float operator()(int row, int column) const { return m[4 * row + column]; }
+
+    // Same convention as createLookAtMatrix: right-handed, the camera looks down -Z
+    static Mat4f lookAt(Vector3 eye, Vector3 center, Vector3 up)
+    {
+        // Vector3 element access may not be inline, every element is read once
+        float e[3] = { eye[0], eye[1], eye[2] };
+        float v[3] = { up[0], up[1], up[2] };
+
+        float f[3] = { center[0] - e[0], center[1] - e[1], center[2] - e[2] };
+        normalize3(f);
+
+        float s[3] = { f[1] * v[2] - f[2] * v[1], f[2] * v[0] - f[0] * v[2], f[0] * v[1] - f[1] * v[0] };
+        normalize3(s);
+
+        float u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+
+        Mat4f r;
+        r.m[0] = s[0], r.m[1] = s[1], r.m[2] = s[2];
+        r.m[4] = u[0], r.m[5] = u[1], r.m[6] = u[2];
+        r.m[8] = -f[0], r.m[9] = -f[1], r.m[10] = -f[2];
+        r.m[3] = -(s[0] * e[0] + s[1] * e[1] + s[2] * e[2]);
+        r.m[7] = -(u[0] * e[0] + u[1] * e[1] + u[2] * e[2]);
+        r.m[11] = f[0] * e[0] + f[1] * e[1] + f[2] * e[2];
+
+        return r;
+    }
+
+private:
+    static void normalize3(float a[3])
+    {
+        float length = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+        if (length > 0.0f)
+        {
+            float inverse = 1.0f / length;
+            a[0] *= inverse, a[1] *= inverse, a[2] *= inverse;
+        }
+    }
+};
+
+inline Mat4f operator*(const Mat4f& a, const Mat4f& b)
+{
+    Mat4f r;
+
+#ifdef SIMD_MATH_SSE
+    // Row i of the product is a linear combination of the rows of b
+    __m128 b0 = _mm_load_ps(b.m), b1 = _mm_load_ps(b.m + 4), b2 = _mm_load_ps(b.m + 8), b3 = _mm_load_ps(b.m + 12);
+
+    for (int i = 0; i < 4; i++)
+    {
+        const float* row = a.m + 4 * i;
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(row[0]), b0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[1]), b1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[2]), b2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(row[3]), b3));
+        _mm_store_ps(r.m + 4 * i, sum);
+    }
+#else
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            r.m[4 * i + j] = a.m[4 * i] * b.m[j] + a.m[4 * i + 1] * b.m[4 + j] + a.m[4 * i + 2] * b.m[8 + j] + a.m[4 * i + 3] * b.m[12 + j];
+#endif
+
+    return r;
+}
+
+inline Vec4f operator*(const Mat4f& a, const Vec4f& p)
+{
+    Vec4f r;
+
+#ifdef SIMD_MATH_SSE
+    __m128 c0 = _mm_set_ps(a.m[12], a.m[8], a.m[4], a.m[0]);
+    __m128 c1 = _mm_set_ps(a.m[13], a.m[9], a.m[5], a.m[1]);
+    __m128 c2 = _mm_set_ps(a.m[14], a.m[10], a.m[6], a.m[2]);
+    __m128 c3 = _mm_set_ps(a.m[15], a.m[11], a.m[7], a.m[3]);
+
+    __m128 sum = _mm_mul_ps(c0, _mm_set1_ps(p.v[0]));
+    sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(p.v[1])));
+    sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(p.v[2])));
+    sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(p.v[3])));
+    _mm_store_ps(r.v, sum);
+#else
+    for (int i = 0; i < 4; i++)
+        r.v[i] = a.m[4 * i] * p.v[0] + a.m[4 * i + 1] * p.v[1] + a.m[4 * i + 2] * p.v[2] + a.m[4 * i + 3] * p.v[3];
+#endif
+
+    return r;
+}
+
+// Transforms count xyz triples, w is 1 for points and 0 for directions. in and out may alias.
+inline void transformBatch(const Mat4f& a, const float* in, float* out, int count, float w)
+{
+#ifdef SIMD_MATH_SSE
+    __m128 c0 = _mm_set_ps(0.0f, a.m[8], a.m[4], a.m[0]);
+    __m128 c1 = _mm_set_ps(0.0f, a.m[9], a.m[5], a.m[1]);
+    __m128 c2 = _mm_set_ps(0.0f, a.m[10], a.m[6], a.m[2]);
+    __m128 c3 = _mm_mul_ps(_mm_set_ps(0.0f, a.m[11], a.m[7], a.m[3]), _mm_set1_ps(w));
+
+    for (int i = 0; i < count; i++)
+    {
+        const float* p = in + 3 * i;
+        __m128 sum = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_set1_ps(p[0])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+
+        alignas(16) float r[4];
+        _mm_store_ps(r, sum);
+        out[3 * i] = r[0], out[3 * i + 1] = r[1], out[3 * i + 2] = r[2];
+    }
+#else
+    for (int i = 0; i < count; i++)
+    {
+        float x = in[3 * i], y = in[3 * i + 1], z = in[3 * i + 2];
+        out[3 * i] = a.m[0] * x + a.m[1] * y + a.m[2] * z + a.m[3] * w;
+        out[3 * i + 1] = a.m[4] * x + a.m[5] * y + a.m[6] * z + a.m[7] * w;
+        out[3 * i + 2] = a.m[8] * x + a.m[9] * y + a.m[10] * z + a.m[11] * w;
+    }
+#endif
+}
+
+inline void transformPoints(const Mat4f& a, const float* in, float* out, int count)
+{
+    transformBatch(a, in, out, count, 1.0f);
+}
+
+inline void transformDirections(const Mat4f& a, const float* in, float* out, int count)
+{
+    transformBatch(a, in, out, count, 0.0f);
+}
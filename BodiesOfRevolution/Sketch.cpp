@@ -0,0 +1,120 @@
+#include "Sketch.h"
+
+static double segmentDistance2(const Point2D& p, const Point2D& a, const Point2D& b)
+{
+    Point2D ab = b - a, ap = p - a;
+    double length2 = ab.x * ab.x + ab.y * ab.y;
+
+    double t = length2 > 0.0 ? (ap.x * ab.x + ap.y * ab.y) / length2 : 0.0;
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+
+    Point2D d = ap - ab * t;
+    return d.x * d.x + d.y * d.y;
+}
+
+static void simplifyPolyline(const std::vector<Point2D>& input, double tolerance, std::vector<Point2D>& output, std::vector<int>& stack, std::vector<char>& keep)
+{
+    output.clear();
+
+    int n = input.size();
+    if (n <= 2)
+    {
+        output = input;
+        return;
+    }
+
+    keep.assign(n, 0);
+    keep[0] = keep[n - 1] = 1;
+
+    // Ranges are processed from an explicit stack, long strokes would overflow a recursion
+    stack.clear();
+    stack.push_back(0);
+    stack.push_back(n - 1);
+
+    double tolerance2 = tolerance * tolerance;
+
+    while (!stack.empty())
+    {
+        int last = stack.back();
+        stack.pop_back();
+        int first = stack.back();
+        stack.pop_back();
+
+        int farthest = -1;
+        double best = tolerance2;
+
+        for (int i = first + 1; i < last; i++)
+        {
+            double distance = segmentDistance2(input[i], input[first], input[last]);
+            if (distance > best)
+            {
+                best = distance;
+                farthest = i;
+            }
+        }
+
+        if (farthest < 0)
+            continue;
+
+        keep[farthest] = 1;
+        stack.push_back(first);
+        stack.push_back(farthest);
+        stack.push_back(farthest);
+        stack.push_back(last);
+    }
+
+    for (int i = 0; i < n; i++)
+        if (keep[i])
+            output.push_back(input[i]);
+}
+
+void simplifyPolyline(const std::vector<Point2D>& input, double tolerance, std::vector<Point2D>& output)
+{
+    std::vector<int> stack;
+    std::vector<char> keep;
+
+    simplifyPolyline(input, tolerance, output, stack, keep);
+}
+
+void Sketch::begin(Point2D point)
+{
+    this->samples.clear();
+    this->samples.push_back(point);
+    this->active = true;
+    this->dirty = true;
+}
+
+void Sketch::sample(Point2D point)
+{
+    if (!this->active)
+        return;
+
+    Point2D d = point - this->samples.back();
+    if (d.x * d.x + d.y * d.y < SKETCH_MIN_SPACING * SKETCH_MIN_SPACING)
+        return;
+
+    this->samples.push_back(point);
+    this->dirty = true;
+}
+
+const std::vector<Point2D>& Sketch::finish(double tolerance)
+{
+    simplifyPolyline(this->samples, tolerance, this->simplified, this->stack, this->keep);
+
+    this->samples.clear();
+    this->active = false;
+    this->dirty = true;
+
+    return this->simplified;
+}
+
+void Sketch::addToOverlay(Overlay& overlay)
+{
+    if (this->active)
+        overlay.addPolyline(this->samples.data(), this->samples.size(), 1.0f, 1.0f, 0.0f);
+}
+
+long long Sketch::memoryBytes() const
+{
+    return vectorBytes(this->samples) + vectorBytes(this->simplified) + vectorBytes(this->stack) + vectorBytes(this->keep);
+}
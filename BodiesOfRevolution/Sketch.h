@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include "tbezier.h"
+#include "Overlay.h"
+
+// Samples closer than this to the previous one are dropped while sketching, in pixels
+#define SKETCH_MIN_SPACING 2.0
+
+// Ramer-Douglas-Peucker: keeps the end points and every point needed to stay within tolerance
+// of the input polyline.
+void simplifyPolyline(const std::vector<Point2D>& input, double tolerance, std::vector<Point2D>& output);
+
+// Freehand stroke of the profile. The cursor is sampled once per frame while the button is held,
+// and the stroke is reduced to control points only when it is finished.
+class Sketch
+{
+public:
+    std::vector<Point2D> samples;
+    std::vector<Point2D> simplified;
+
+    bool active = false;
+
+    // Set when samples were added, cleared by the main loop once the stroke is on screen
+    bool dirty = false;
+
+    void begin(Point2D point);
+
+    void sample(Point2D point);
+
+    // Returns the simplified control points of the stroke
+    const std::vector<Point2D>& finish(double tolerance);
+
+    void addToOverlay(Overlay& overlay);
+
+    long long memoryBytes() const;
+
+private:
+    std::vector<int> stack;
+    std::vector<char> keep;
+};
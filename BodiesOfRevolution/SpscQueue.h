@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+
+// Lock-free single producer / single consumer ring buffer. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T& item)
+    {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - this->head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        this->items[tail & (Capacity - 1)] = item;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == this->tail.load(std::memory_order_acquire))
+            return false;
+
+        item = this->items[head & (Capacity - 1)];
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return this->head.load(std::memory_order_acquire) == this->tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[Capacity];
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+};
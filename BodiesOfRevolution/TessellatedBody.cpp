@@ -0,0 +1,252 @@
+#include "TessellatedBody.h"
+#include "BodyOfRevolution.h"
+#include "FrameUniforms.h"
+#include "GLState.h"
+#include "Tools.h"
+
+bool TessellatedBody::create()
+{
+    GLint major = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+
+    this->supported = major >= 4 && createShaderProgram();
+    if (!this->supported)
+        return false;
+
+    GLint level = 0;
+    glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &level);
+    if (level > 0)
+        this->maxLevel = level;
+
+    if (!this->model.create(false))
+        return false;
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (const GLvoid*)0);
+
+    GLState::bindVertexArray(0);
+
+    return true;
+}
+
+void TessellatedBody::build(const std::vector<Segment>& segments)
+{
+    if (!this->supported)
+        return;
+
+    // Every patch vertex holds a control point (axial, radial) and the sector as fractions of a turn.
+    // Neighbouring patches get bit-identical shared values, which keeps the tessellation crack-free.
+    std::vector<GLfloat> cage;
+    cage.reserve(segments.size() * TESS_SECTORS * 16);
+
+    for (const Segment& segment : segments)
+        for (int j = 0; j < TESS_SECTORS; j++)
+        {
+            float turn0 = (float)j / TESS_SECTORS;
+            float turn1 = (float)(j + 1) / TESS_SECTORS;
+
+            for (int k = 0; k < 4; k++)
+            {
+                cage.push_back(segment.points[k].x);
+                cage.push_back(segment.points[k].y);
+                cage.push_back(turn0);
+                cage.push_back(turn1);
+            }
+        }
+
+    this->patchCount = segments.size() * TESS_SECTORS;
+
+    this->model.uploadVertices(cage.data(), cage.size() * sizeof(GLfloat), GL_STATIC_DRAW);
+}
+
+void TessellatedBody::draw(const Mat4f& view, const Mat4f& model, int viewportWidth, int viewportHeight)
+{
+    if (!this->supported || this->patchCount == 0)
+        return;
+
+    GLState::useProgram(this->shaderProgram);
+    GLState::bindVertexArray(this->model.vao);
+
+    Mat4f MV = view * model;
+
+    GLfloat N[9];
+    createNormalMatrix(MV.m, N);
+
+    glUniformMatrix4fv(this->uMV, 1, GL_TRUE, MV.m);
+    glUniformMatrix3fv(this->uN, 1, GL_TRUE, N);
+    glUniform2f(this->uViewport, viewportWidth, viewportHeight);
+    glUniform1f(this->uPixelsPerEdge, TESS_PIXELS_PER_EDGE);
+    glUniform1f(this->uMaxLevel, this->maxLevel);
+    glUniform4fv(this->uClipPlane, 1, this->clipPlane);
+
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+    glDrawArrays(GL_PATCHES, 0, 4 * this->patchCount);
+}
+
+void TessellatedBody::cleanup()
+{
+    if (this->shaderProgram != 0)
+        GLState::deleteProgram(this->shaderProgram);
+
+    this->model.release();
+}
+
+bool TessellatedBody::createShaderProgram()
+{
+    this->shaderProgram = 0;
+
+    const GLchar vsh[] =
+        "#version 400\n"
+        ""
+        "layout(location = 0) in vec4 a_control;"
+        ""
+        "out vec4 v_control;"
+        ""
+        "void main()"
+        "{"
+        "    v_control = a_control;"
+        "}"
+        ;
+
+    const GLchar tcsh[] =
+        "#version 400\n"
+        ""
+        "layout(vertices = 4) out;"
+        ""
+        CAMERA_BLOCK
+        ""
+        "uniform mat4 u_mv;"
+        "uniform vec2 u_viewport;"
+        "uniform float u_pixelsPerEdge;"
+        "uniform float u_maxLevel;"
+        ""
+        "in vec4 v_control[];"
+        "out vec4 c_control[];"
+        ""
+        "vec2 screen(vec2 p, float turn)"
+        "{"
+        "    float angle = 6.28318531 * fract(turn);"
+        "    vec4 clip = u_projection * (u_mv * vec4(p.x, p.y * cos(angle), p.y * sin(angle), 1.0));"
+        "    return clip.xy / max(clip.w, 0.001) * 0.5 * u_viewport;"
+        "}"
+        ""
+        "float level(float pixels)"
+        "{"
+        "    return clamp(pixels / u_pixelsPerEdge, 1.0, u_maxLevel);"
+        "}"
+        ""
+        // Control polygon of the profile at one sector border
+        "float profileEdge(float turn)"
+        "{"
+        "    vec2 a = screen(v_control[0].xy, turn);"
+        "    vec2 b = screen(v_control[1].xy, turn);"
+        "    vec2 c = screen(v_control[2].xy, turn);"
+        "    vec2 d = screen(v_control[3].xy, turn);"
+        "    return length(b - a) + length(c - b) + length(d - c);"
+        "}"
+        ""
+        // Circle arc of one profile end point across the sector
+        "float arcEdge(vec2 p, float turn0, float turn1)"
+        "{"
+        "    vec2 a = screen(p, turn0);"
+        "    vec2 b = screen(p, 0.5 * (turn0 + turn1));"
+        "    vec2 c = screen(p, turn1);"
+        "    return length(b - a) + length(c - b);"
+        "}"
+        ""
+        "void main()"
+        "{"
+        "    c_control[gl_InvocationID] = v_control[gl_InvocationID];"
+        ""
+        "    if (gl_InvocationID == 0)"
+        "    {"
+        // Each outer level depends only on data the neighbouring patch shares, so both sides agree
+        "        float turn0 = v_control[0].z, turn1 = v_control[0].w;"
+        "        float left = level(arcEdge(v_control[0].xy, turn0, turn1));"
+        "        float bottom = level(profileEdge(turn0));"
+        "        float right = level(arcEdge(v_control[3].xy, turn0, turn1));"
+        "        float top = level(profileEdge(turn1));"
+        ""
+        "        gl_TessLevelOuter[0] = left;"
+        "        gl_TessLevelOuter[1] = bottom;"
+        "        gl_TessLevelOuter[2] = right;"
+        "        gl_TessLevelOuter[3] = top;"
+        "        gl_TessLevelInner[0] = max(bottom, top);"
+        "        gl_TessLevelInner[1] = max(left, right);"
+        "    }"
+        "}"
+        ;
+
+    const GLchar tesh[] =
+        "#version 400\n"
+        ""
+        "layout(quads, fractional_even_spacing, ccw) in;"
+        ""
+        CAMERA_BLOCK
+        ""
+        "uniform mat4 u_mv;"
+        "uniform mat3 u_n;"
+        "uniform vec4 u_clipPlane;"
+        ""
+        "in vec4 c_control[];"
+        ""
+        "out vec3 v_normal;"
+        "out vec3 v_position;"
+        ""
+        "void main()"
+        "{"
+        "    vec2 p0 = c_control[0].xy, p1 = c_control[1].xy, p2 = c_control[2].xy, p3 = c_control[3].xy;"
+        "    float t = gl_TessCoord.x, s = 1.0 - t;"
+        ""
+        "    vec2 p = s * s * s * p0 + 3.0 * s * s * t * p1 + 3.0 * s * t * t * p2 + t * t * t * p3;"
+        "    vec2 d = 3.0 * s * s * (p1 - p0) + 6.0 * s * t * (p2 - p1) + 3.0 * t * t * (p3 - p2);"
+        ""
+        // Same fallback as Segment::tangent where a control point coincides with an end point
+        "    if (dot(d, d) < 1.0e-12)"
+        "        d = p3 - p0;"
+        "    d = normalize(d);"
+        ""
+        "    float angle = 6.28318531 * fract(mix(c_control[0].z, c_control[0].w, gl_TessCoord.y));"
+        "    float c = cos(angle), sn = sin(angle);"
+        ""
+        "    vec4 surface = vec4(p.x, p.y * c, p.y * sn, 1.0);"
+        "    vec4 position = u_mv * surface;"
+        "    v_normal = u_n * vec3(-d.y, d.x * c, d.x * sn);"
+        "    v_position = vec3(position);"
+        "    gl_Position = u_projection * position;"
+        "    gl_ClipDistance[0] = dot(u_clipPlane, surface);"
+        "}"
+        ;
+
+    const GLchar fsh[] = BODY_FRAGMENT_SHADER;
+
+    GLuint vertexShader, controlShader, evaluationShader, fragmentShader;
+
+    vertexShader = createShader(vsh, GL_VERTEX_SHADER);
+    controlShader = createShader(tcsh, GL_TESS_CONTROL_SHADER);
+    evaluationShader = createShader(tesh, GL_TESS_EVALUATION_SHADER);
+    fragmentShader = createShader(fsh, GL_FRAGMENT_SHADER);
+
+    if (vertexShader != 0 && controlShader != 0 && evaluationShader != 0 && fragmentShader != 0)
+        this->shaderProgram = createProgram(vertexShader, controlShader, evaluationShader, fragmentShader);
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(controlShader);
+    glDeleteShader(evaluationShader);
+    glDeleteShader(fragmentShader);
+
+    // Compile and link errors are already printed, the body is then drawn from the mesh
+    if (this->shaderProgram == 0)
+        return false;
+
+    this->uMV = glGetUniformLocation(this->shaderProgram, "u_mv");
+    this->uN = glGetUniformLocation(this->shaderProgram, "u_n");
+    this->uViewport = glGetUniformLocation(this->shaderProgram, "u_viewport");
+    this->uPixelsPerEdge = glGetUniformLocation(this->shaderProgram, "u_pixelsPerEdge");
+    this->uMaxLevel = glGetUniformLocation(this->shaderProgram, "u_maxLevel");
+    this->uClipPlane = glGetUniformLocation(this->shaderProgram, "u_clipPlane");
+
+    FrameUniforms::bind(this->shaderProgram);
+
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include "tbezier.h"
+#include "SimdMath.h"
+#include "Model.h"
+
+// Angular sectors of the coarse revolution cage, every Bezier segment gives one patch per sector
+#define TESS_SECTORS 16
+
+// Target length of a tessellated edge on screen, in pixels
+#define TESS_PIXELS_PER_EDGE 8.0f
+
+// Body renderer for GL 4.0+: only the Bezier control points are uploaded, one quad patch per
+// segment and sector, and the tessellation shaders evaluate the profile and the revolution.
+// Edge levels follow the projected edge length, so detail adapts to the camera without remeshing.
+class TessellatedBody
+{
+public:
+    GLuint shaderProgram = 0;
+    Model model{ MemorySubsystem::tessellation };
+    GLint uMV, uN, uViewport, uPixelsPerEdge, uMaxLevel, uClipPlane;
+
+    int patchCount = 0;
+    float maxLevel = 64.0f;
+
+    // Same as BodyOfRevolution::clipPlane
+    float clipPlane[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    // False when the context has no tessellation support, the mesh renderer is used then
+    bool supported = false;
+
+    bool create();
+
+    void build(const std::vector<Segment>& segments);
+
+    void draw(const Mat4f& view, const Mat4f& model, int viewportWidth, int viewportHeight);
+
+    void cleanup();
+
+private:
+    bool createShaderProgram();
+};
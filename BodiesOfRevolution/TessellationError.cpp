@@ -0,0 +1,435 @@
+#include "TessellationError.h"
+#include "DistanceField.h"
+#include "MeshKernels.h"
+#include "Parallel.h"
+#include "RevolutionMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+static const double TWO_PI = 6.283185307179586;
+static const double RADIANS_TO_DEGREES = 57.29577951308232;
+
+// Step of the finite differences for the surface normal, in profile units
+static const double GRADIENT_STEP = 1.0e-3;
+
+// Surface samples per mesh sample interval along the profile and around the axis
+static const int SURFACE_OVERSAMPLING = 4;
+
+class Vec3d
+{
+public:
+    double x, y, z;
+
+    Vec3d() : x(0.0), y(0.0), z(0.0) {}
+    Vec3d(double x, double y, double z) : x(x), y(y), z(z) {}
+
+    Vec3d operator+(const Vec3d& v) const { return Vec3d(x + v.x, y + v.y, z + v.z); }
+    Vec3d operator-(const Vec3d& v) const { return Vec3d(x - v.x, y - v.y, z - v.z); }
+    Vec3d operator*(double s) const { return Vec3d(x * s, y * s, z * s); }
+
+    double dot(const Vec3d& v) const { return x * v.x + y * v.y + z * v.z; }
+};
+
+// Uniform grid over the triangle bounding boxes for closest triangle queries
+class TriangleGrid
+{
+public:
+    void build(const RevolutionMesh& mesh)
+    {
+        this->mesh = &mesh;
+        int count = mesh.triangleCount();
+
+        this->lo = Vec3d(1.0e300, 1.0e300, 1.0e300);
+        this->hi = Vec3d(-1.0e300, -1.0e300, -1.0e300);
+        for (int v = 0; v < mesh.vertexCount(); v++)
+        {
+            Vec3d p = vertex(v);
+            this->lo = Vec3d(std::min(this->lo.x, p.x), std::min(this->lo.y, p.y), std::min(this->lo.z, p.z));
+            this->hi = Vec3d(std::max(this->hi.x, p.x), std::max(this->hi.y, p.y), std::max(this->hi.z, p.z));
+        }
+
+        // About two triangles per cell on a surface
+        Vec3d size = this->hi - this->lo;
+        double area = 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+        this->cell = std::max(sqrt(area / std::max(count, 1)) * 1.5, 1.0e-6);
+
+        this->n[0] = std::max(1, (int)(size.x / this->cell) + 1);
+        this->n[1] = std::max(1, (int)(size.y / this->cell) + 1);
+        this->n[2] = std::max(1, (int)(size.z / this->cell) + 1);
+
+        this->cells.assign((size_t)this->n[0] * this->n[1] * this->n[2], std::vector<int>());
+
+        for (int t = 0; t < count; t++)
+        {
+            Vec3d a = vertex(mesh.indices[3 * t]), b = vertex(mesh.indices[3 * t + 1]), c = vertex(mesh.indices[3 * t + 2]);
+
+            int c0[3], c1[3];
+            cellOf(Vec3d(std::min(a.x, std::min(b.x, c.x)), std::min(a.y, std::min(b.y, c.y)), std::min(a.z, std::min(b.z, c.z))), c0);
+            cellOf(Vec3d(std::max(a.x, std::max(b.x, c.x)), std::max(a.y, std::max(b.y, c.y)), std::max(a.z, std::max(b.z, c.z))), c1);
+
+            for (int i = c0[0]; i <= c1[0]; i++)
+                for (int j = c0[1]; j <= c1[1]; j++)
+                    for (int k = c0[2]; k <= c1[2]; k++)
+                        this->cells[index(i, j, k)].push_back(t);
+        }
+    }
+
+    // Searches shells of cells around the query until no closer triangle can exist
+    double distance(const Vec3d& p) const
+    {
+        int c[3];
+        cellOf(p, c);
+
+        double best = 1.0e300;
+        int maxShell = std::max(this->n[0], std::max(this->n[1], this->n[2]));
+
+        for (int shell = 0; shell <= maxShell; shell++)
+        {
+            for (int i = c[0] - shell; i <= c[0] + shell; i++)
+                for (int j = c[1] - shell; j <= c[1] + shell; j++)
+                    for (int k = c[2] - shell; k <= c[2] + shell; k++)
+                    {
+                        bool surface = abs(i - c[0]) == shell || abs(j - c[1]) == shell || abs(k - c[2]) == shell;
+                        if (!surface || i < 0 || j < 0 || k < 0 || i >= this->n[0] || j >= this->n[1] || k >= this->n[2])
+                            continue;
+
+                        if (cellDistance2(p, i, j, k) >= best)
+                            continue;
+
+                        for (int t : this->cells[index(i, j, k)])
+                            best = std::min(best, triangleDistance2(p, t));
+                    }
+
+            // Everything outside this shell is at least shell cells away
+            double reach = shell * this->cell;
+            if (best < 1.0e300 && best <= reach * reach)
+                break;
+        }
+
+        return sqrt(best);
+    }
+
+private:
+    const RevolutionMesh* mesh = NULL;
+    Vec3d lo, hi;
+    double cell = 1.0;
+    int n[3] = { 1, 1, 1 };
+    std::vector<std::vector<int>> cells;
+
+    Vec3d vertex(int v) const
+    {
+        const float* p = &this->mesh->vertices[6 * v];
+        return Vec3d(p[0], p[1], p[2]);
+    }
+
+    size_t index(int i, int j, int k) const
+    {
+        return ((size_t)i * this->n[1] + j) * this->n[2] + k;
+    }
+
+    void cellOf(const Vec3d& p, int c[3]) const
+    {
+        double v[3] = { p.x - this->lo.x, p.y - this->lo.y, p.z - this->lo.z };
+        for (int a = 0; a < 3; a++)
+            c[a] = std::min(this->n[a] - 1, std::max(0, (int)(v[a] / this->cell)));
+    }
+
+    double cellDistance2(const Vec3d& p, int i, int j, int k) const
+    {
+        double v[3] = { p.x - this->lo.x, p.y - this->lo.y, p.z - this->lo.z };
+        int c[3] = { i, j, k };
+
+        double result = 0.0;
+        for (int a = 0; a < 3; a++)
+        {
+            double d = std::max(std::max(c[a] * this->cell - v[a], v[a] - (c[a] + 1) * this->cell), 0.0);
+            result += d * d;
+        }
+        return result;
+    }
+
+    // Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+    double triangleDistance2(const Vec3d& p, int t) const
+    {
+        Vec3d a = vertex(this->mesh->indices[3 * t]), b = vertex(this->mesh->indices[3 * t + 1]), c = vertex(this->mesh->indices[3 * t + 2]);
+        Vec3d ab = b - a, ac = c - a, ap = p - a;
+
+        double d1 = ab.dot(ap), d2 = ac.dot(ap);
+        if (d1 <= 0.0 && d2 <= 0.0)
+            return ap.dot(ap);
+
+        Vec3d bp = p - b;
+        double d3 = ab.dot(bp), d4 = ac.dot(bp);
+        if (d3 >= 0.0 && d4 <= d3)
+            return bp.dot(bp);
+
+        double vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+            return squared(p - (a + ab * (d1 / (d1 - d3))));
+
+        Vec3d cp = p - c;
+        double d5 = ab.dot(cp), d6 = ac.dot(cp);
+        if (d6 >= 0.0 && d5 <= d6)
+            return cp.dot(cp);
+
+        double vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+            return squared(p - (a + ac * (d2 / (d2 - d6))));
+
+        double va = d3 * d6 - d5 * d4;
+        if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+            return squared(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+
+        double denominator = 1.0 / (va + vb + vc);
+        return squared(p - (a + ab * (vb * denominator) + ac * (vc * denominator)));
+    }
+
+    static double squared(const Vec3d& v)
+    {
+        return v.dot(v);
+    }
+};
+
+// Angle between a mesh normal and the surface normal at a point, orientation independent
+static double normalError(const DistanceField& field, const Vec3d& p, const Vec3d& normal)
+{
+    double r = sqrt(p.y * p.y + p.z * p.z);
+    double h = GRADIENT_STEP;
+
+    double gx = field.profileDistance(p.x + h, r) - field.profileDistance(p.x - h, r);
+    double gr = field.profileDistance(p.x, r + h) - field.profileDistance(p.x, std::max(r - h, 0.0));
+
+    // Profile space gradient rotated into the half plane of the point
+    Vec3d g(gx, 0.0, 0.0);
+    if (r > 0.0)
+        g = Vec3d(gx, gr * p.y / r, gr * p.z / r);
+
+    double lengths = sqrt(g.dot(g) * normal.dot(normal));
+    if (lengths <= 0.0)
+        return 0.0;
+
+    double cosine = std::min(1.0, fabs(g.dot(normal)) / lengths);
+    return acos(cosine) * RADIANS_TO_DEGREES;
+}
+
+double TessellationReport::hausdorff() const
+{
+    return std::max(this->maxMeshToSurface, this->maxSurfaceToMesh);
+}
+
+void TessellationReport::print() const
+{
+    std::cout << this->samplesPerSegment << " samples x " << this->revolutions << " revolutions: " << this->triangles << " triangles in "
+        << this->meshMilliseconds << " ms, Hausdorff " << hausdorff() << " (mesh to surface max " << this->maxMeshToSurface
+        << " mean " << this->meanMeshToSurface << ", surface to mesh max " << this->maxSurfaceToMesh << " mean " << this->meanSurfaceToMesh
+        << "), normals max " << this->maxNormalDegrees << " mean " << this->meanNormalDegrees << " degrees" << std::endl;
+
+    for (int i = 0; i < (int)this->regions.size(); i++)
+    {
+        const RegionError& region = this->regions[i];
+        std::cout << "  segment " << i << ": max " << region.maxDeviation << " mean " << region.meanDeviation
+            << " normal " << region.maxNormalDegrees << " degrees" << std::endl;
+    }
+}
+
+bool measureTessellation(const std::vector<Segment>& segments, int samplesPerSegment, int revolutions, TessellationReport& report)
+{
+    report = TessellationReport();
+    report.samplesPerSegment = samplesPerSegment;
+    report.revolutions = revolutions;
+
+    int segmentCount = segments.size();
+    if (segmentCount == 0 || samplesPerSegment < 1 || revolutions < 3)
+        return false;
+
+    // Mesh exactly like the editor does, timing the sampling and the revolution
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Point2D> points(segmentCount * samplesPerSegment + 1), tangents(points.size());
+    SampleKernel kernel = findSampleKernel(samplesPerSegment);
+    for (int i = 0; i < segmentCount; i++)
+    {
+        Point2D* p = points.data() + i * samplesPerSegment;
+        Point2D* t = tangents.data() + i * samplesPerSegment;
+        if (kernel != NULL)
+            kernel(segments[i], p, t);
+        else
+            sampleSegmentGeneric(segments[i], samplesPerSegment, p, t);
+    }
+    points.back() = segments.back().points[3];
+    tangents.back() = segments.back().tangent(1.0);
+
+    RevolutionMesh mesh;
+    if (!mesh.build(points, tangents, revolutions))
+        return false;
+
+    report.meshMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    report.triangles = mesh.triangleCount();
+
+    // Profile sample of every vertex, poles have one vertex
+    std::vector<int> vertexSample;
+    vertexSample.reserve(mesh.vertexCount());
+    for (int k = 0; k < (int)points.size(); k++)
+        vertexSample.insert(vertexSample.end(), fabs(points[k].y) < POLE_TOLERANCE ? 1 : revolutions, k);
+
+    Matrix4 identity = createScaleMatrix(1.0f, 1.0f, 1.0f);
+    DistanceField field;
+    field.build(segments, identity);
+
+    std::vector<double> sumDeviation(segmentCount, 0.0);
+    report.regions.assign(segmentCount, RegionError());
+
+    // Mesh to surface: the centroid and three inner points of every triangle
+    const double weights[4][3] = { { 1.0 / 3, 1.0 / 3, 1.0 / 3 }, { 4.0 / 6, 1.0 / 6, 1.0 / 6 }, { 1.0 / 6, 4.0 / 6, 1.0 / 6 }, { 1.0 / 6, 1.0 / 6, 4.0 / 6 } };
+
+    int stride = std::max(1, report.triangles * 4 / TESS_ERROR_MAX_SAMPLES);
+    int triangleSamples = (report.triangles + stride - 1) / stride;
+
+    std::vector<double> deviation(4 * triangleSamples), normalDegrees(triangleSamples);
+    std::vector<int> region(triangleSamples);
+
+    parallelFor(triangleSamples, 1024, [&](int begin, int end)
+    {
+        for (int s = begin; s < end; s++)
+        {
+            int t = s * stride;
+            const float* v[3];
+            for (int k = 0; k < 3; k++)
+                v[k] = &mesh.vertices[6 * mesh.indices[3 * t + k]];
+
+            // Ring k to ring k + 1 belongs to the segment of sample k
+            int sample = std::min(vertexSample[mesh.indices[3 * t]], std::min(vertexSample[mesh.indices[3 * t + 1]], vertexSample[mesh.indices[3 * t + 2]]));
+            region[s] = std::min(sample / samplesPerSegment, segmentCount - 1);
+
+            for (int w = 0; w < 4; w++)
+            {
+                Vec3d p, normal;
+                for (int k = 0; k < 3; k++)
+                {
+                    p = p + Vec3d(v[k][0], v[k][1], v[k][2]) * weights[w][k];
+                    normal = normal + Vec3d(v[k][3], v[k][4], v[k][5]) * weights[w][k];
+                }
+
+                // The field refines to the cubic, its polyline shares sample points with the mesh
+                deviation[4 * s + w] = fabs(field.profileDistance(p.x, sqrt(p.y * p.y + p.z * p.z)));
+                if (w == 0)
+                    normalDegrees[s] = normalError(field, p, normal);
+            }
+        }
+    });
+
+    double sum = 0.0, normalSum = 0.0;
+    for (int s = 0; s < triangleSamples; s++)
+    {
+        RegionError& r = report.regions[region[s]];
+        for (int w = 0; w < 4; w++)
+        {
+            double d = deviation[4 * s + w];
+            report.maxMeshToSurface = std::max(report.maxMeshToSurface, d);
+            r.maxDeviation = std::max(r.maxDeviation, d);
+            sumDeviation[region[s]] += d;
+            sum += d;
+            r.samples++;
+        }
+
+        report.maxNormalDegrees = std::max(report.maxNormalDegrees, normalDegrees[s]);
+        r.maxNormalDegrees = std::max(r.maxNormalDegrees, normalDegrees[s]);
+        normalSum += normalDegrees[s];
+    }
+    report.meanMeshToSurface = sum / (4.0 * triangleSamples);
+    report.meanNormalDegrees = normalSum / triangleSamples;
+
+    // Surface to mesh: a denser grid on the analytic surface than the mesh was built from
+    int along = samplesPerSegment * SURFACE_OVERSAMPLING, around = revolutions * SURFACE_OVERSAMPLING;
+    while ((long long)segmentCount * along * around > TESS_ERROR_MAX_SAMPLES && (along > 2 || around > 8))
+    {
+        along = std::max(2, along / 2);
+        around = std::max(8, around / 2);
+    }
+
+    TriangleGrid grid;
+    grid.build(mesh);
+
+    int surfaceSamples = segmentCount * along * around;
+    std::vector<double> surfaceDeviation(surfaceSamples);
+
+    parallelFor(surfaceSamples, 1024, [&](int begin, int end)
+    {
+        for (int s = begin; s < end; s++)
+        {
+            int segment = s / (along * around);
+            int u = s / around % along;
+            int a = s % around;
+
+            // Offsets keep the samples off the mesh rings and meridians, where the error is zero
+            Point2D q = segments[segment].calc((u + 0.5) / along);
+            double angle = TWO_PI * (a + 0.5) / around;
+
+            surfaceDeviation[s] = grid.distance(Vec3d(q.x, q.y * cos(angle), q.y * sin(angle)));
+        }
+    });
+
+    sum = 0.0;
+    for (int s = 0; s < surfaceSamples; s++)
+    {
+        int segment = s / (along * around);
+        double d = surfaceDeviation[s];
+
+        report.maxSurfaceToMesh = std::max(report.maxSurfaceToMesh, d);
+        report.regions[segment].maxDeviation = std::max(report.regions[segment].maxDeviation, d);
+        report.regions[segment].samples++;
+        sumDeviation[segment] += d;
+        sum += d;
+    }
+    report.meanSurfaceToMesh = sum / surfaceSamples;
+
+    for (int i = 0; i < segmentCount; i++)
+        if (report.regions[i].samples > 0)
+            report.regions[i].meanDeviation = sumDeviation[i] / report.regions[i].samples;
+
+    return true;
+}
+
+bool chooseTessellation(const std::vector<Segment>& segments, double tolerance, const std::vector<int>& samplesCandidates,
+    const std::vector<int>& revolutionsCandidates, TessellationReport& report)
+{
+    // Triangle count grows with both settings, so the first candidate within tolerance is the cheapest
+    std::vector<std::pair<int, int>> order;
+    for (int samples : samplesCandidates)
+        for (int revolutions : revolutionsCandidates)
+            order.push_back(std::make_pair(samples, revolutions));
+
+    std::sort(order.begin(), order.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b)
+    {
+        return (long long)a.first * a.second < (long long)b.first * b.second;
+    });
+
+    std::vector<std::pair<int, int>> failed;
+    TessellationReport candidate, mostAccurate;
+
+    for (const std::pair<int, int>& settings : order)
+    {
+        // The error only shrinks with finer settings, a candidate coarser than a failed one fails too
+        bool dominated = false;
+        for (const std::pair<int, int>& f : failed)
+            if (settings.first <= f.first && settings.second <= f.second)
+                dominated = true;
+
+        if (dominated || !measureTessellation(segments, settings.first, settings.second, candidate))
+            continue;
+
+        if (candidate.hausdorff() <= tolerance)
+        {
+            report = candidate;
+            return true;
+        }
+
+        failed.push_back(settings);
+        if (mostAccurate.triangles == 0 || candidate.hausdorff() < mostAccurate.hausdorff())
+            mostAccurate = candidate;
+    }
+
+    report = mostAccurate;
+    return false;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "tbezier.h"
+
+// Upper bound on the distance samples taken in each direction, larger meshes are subsampled
+#define TESS_ERROR_MAX_SAMPLES 262144
+
+class RegionError
+{
+public:
+    double maxDeviation = 0.0;
+    double meanDeviation = 0.0;
+    double maxNormalDegrees = 0.0;
+    int samples = 0;
+};
+
+// Deviation of a body mesh from the exact surface of revolution of its profile, in profile units.
+// Mesh to surface samples points on every triangle and measures them against the Bezier curves of
+// the profile, so the chordal error along the profile counts as well as the facets around the axis.
+// Surface to mesh samples the analytic surface more densely than the mesh; their maximum is the
+// (sampled) Hausdorff distance.
+class TessellationReport
+{
+public:
+    int samplesPerSegment = 0;
+    int revolutions = 0;
+    int triangles = 0;
+    double meshMilliseconds = 0.0;
+
+    double maxMeshToSurface = 0.0;
+    double meanMeshToSurface = 0.0;
+    double maxSurfaceToMesh = 0.0;
+    double meanSurfaceToMesh = 0.0;
+
+    // Angle between the interpolated mesh normal and the surface normal
+    double maxNormalDegrees = 0.0;
+    double meanNormalDegrees = 0.0;
+
+    // One region per Bezier segment, both directions combined
+    std::vector<RegionError> regions;
+
+    double hausdorff() const;
+
+    void print() const;
+};
+
+// Meshes the profile with the given settings and measures the result. Takes up to a second
+// for a detailed body, so it runs on the edit worker rather than the render thread.
+bool measureTessellation(const std::vector<Segment>& segments, int samplesPerSegment, int revolutions, TessellationReport& report);
+
+// Picks the candidate with the fewest triangles whose Hausdorff distance is within tolerance.
+// Returns false when no candidate meets it, report then holds the most accurate one.
+bool chooseTessellation(const std::vector<Segment>& segments, double tolerance, const std::vector<int>& samplesCandidates,
+    const std::vector<int>& revolutionsCandidates, TessellationReport& report);
@@ -1,5 +1,7 @@
 #include "Tools.h"
+#include "GLState.h"
 #include <iostream>
+#include <math.h>
 
 GLuint createShader(const GLchar* code, GLenum type)
 {
@@ -28,13 +30,8 @@ GLuint createShader(const GLchar* code, GLenum type)
     return result;
 }
 
-GLuint createProgram(GLuint vsh, GLuint fsh)
+static GLuint linkProgram(GLuint result)
 {
-    GLuint result = glCreateProgram();
-
-    glAttachShader(result, vsh);
-    glAttachShader(result, fsh);
-
     glLinkProgram(result);
 
     GLint linked;
@@ -50,9 +47,90 @@ GLuint createProgram(GLuint vsh, GLuint fsh)
             glGetProgramInfoLog(result, infoLen, NULL, infoLog);
             std::cout << "Shader program linking error" << std::endl << infoLog << std::endl;
         }
-        glDeleteProgram(result);
+        GLState::deleteProgram(result);
         return 0;
     }
 
     return result;
 }
+
+GLuint createProgram(GLuint vsh, GLuint fsh)
+{
+    GLuint result = glCreateProgram();
+
+    glAttachShader(result, vsh);
+    glAttachShader(result, fsh);
+
+    return linkProgram(result);
+}
+
+GLuint createProgram(GLuint vsh, GLuint tcsh, GLuint tesh, GLuint fsh)
+{
+    GLuint result = glCreateProgram();
+
+    glAttachShader(result, vsh);
+    glAttachShader(result, tcsh);
+    glAttachShader(result, tesh);
+    glAttachShader(result, fsh);
+
+    return linkProgram(result);
+}
+
+void transformPoint(const double m[16], const double p[3], double out[3])
+{
+    for (int i = 0; i < 3; i++)
+        out[i] = m[4 * i] * p[0] + m[4 * i + 1] * p[1] + m[4 * i + 2] * p[2] + m[4 * i + 3];
+}
+
+void transformDirection(const double m[16], const double p[3], double out[3])
+{
+    for (int i = 0; i < 3; i++)
+        out[i] = m[4 * i] * p[0] + m[4 * i + 1] * p[1] + m[4 * i + 2] * p[2];
+}
+
+void invertAffine(const double m[16], double out[16])
+{
+    double a = m[0], b = m[1], c = m[2];
+    double d = m[4], e = m[5], f = m[6];
+    double g = m[8], h = m[9], k = m[10];
+
+    double det = a * (e * k - f * h) - b * (d * k - f * g) + c * (d * h - e * g);
+    double invDet = fabs(det) < 1.0e-12 ? 0.0 : 1.0 / det;
+
+    out[0] = (e * k - f * h) * invDet;
+    out[1] = (c * h - b * k) * invDet;
+    out[2] = (b * f - c * e) * invDet;
+    out[4] = (f * g - d * k) * invDet;
+    out[5] = (a * k - c * g) * invDet;
+    out[6] = (c * d - a * f) * invDet;
+    out[8] = (d * h - e * g) * invDet;
+    out[9] = (b * g - a * h) * invDet;
+    out[10] = (a * e - b * d) * invDet;
+
+    for (int i = 0; i < 3; i++)
+        out[4 * i + 3] = -(out[4 * i] * m[3] + out[4 * i + 1] * m[7] + out[4 * i + 2] * m[11]);
+
+    out[12] = out[13] = out[14] = 0.0;
+    out[15] = 1.0;
+}
+
+void createNormalMatrix(const float m[16], float out[9])
+{
+    double a = m[0], b = m[1], c = m[2];
+    double d = m[4], e = m[5], f = m[6];
+    double g = m[8], h = m[9], k = m[10];
+
+    double det = a * (e * k - f * h) - b * (d * k - f * g) + c * (d * h - e * g);
+    double invDet = fabs(det) < 1.0e-12 ? 0.0 : 1.0 / det;
+
+    // Inverse transpose is the cofactor matrix divided by the determinant
+    out[0] = (e * k - f * h) * invDet;
+    out[1] = (f * g - d * k) * invDet;
+    out[2] = (d * h - e * g) * invDet;
+    out[3] = (c * h - b * k) * invDet;
+    out[4] = (a * k - c * g) * invDet;
+    out[5] = (b * g - a * h) * invDet;
+    out[6] = (b * f - c * e) * invDet;
+    out[7] = (c * d - a * f) * invDet;
+    out[8] = (a * e - b * d) * invDet;
+}
@@ -4,3 +4,17 @@
 GLuint createShader(const GLchar* code, GLenum type);
 
 GLuint createProgram(GLuint vsh, GLuint fsh);
+
+// Program with tessellation control and evaluation stages
+GLuint createProgram(GLuint vsh, GLuint tcsh, GLuint tesh, GLuint fsh);
+
+// Row-major 4x4 affine transforms, as stored in Matrix4::elements
+
+void transformPoint(const double m[16], const double p[3], double out[3]);
+
+void transformDirection(const double m[16], const double p[3], double out[3]);
+
+void invertAffine(const double m[16], double out[16]);
+
+// Inverse transpose of the upper 3x3 block of a row-major 4x4 matrix, row-major result
+void createNormalMatrix(const float m[16], float out[9]);
@@ -2,10 +2,28 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <chrono>
+#include <thread>
 #include <vector>
 #include "Points.h"
 #include "Curve.h"
 #include "BodyOfRevolution.h"
+#include "RayCaster.h"
+#include "MassProperties.h"
+#include "DistanceField.h"
+#include "EditWorker.h"
+#include "FrameUniforms.h"
+#include "Overlay.h"
+#include "TessellatedBody.h"
+#include "Sketch.h"
+#include "InputRecorder.h"
+#include "MemoryRegistry.h"
+#include "GLState.h"
+#include "CurveRenderer.h"
+#include "CrossSection.h"
+#include "Benchmark.h"
+#include "AllocationCheck.h"
+#include <algorithm>
+#include <string.h>
 
 /*
 
@@ -13,8 +31,10 @@ Control settings:
 
 When creating body:
 Enter - start building body of revolution
-Left mouse button - make point
+Left mouse button - make point or drag an existing one
 BackSpace - remove last point
+K - switch between placing points and sketching the profile with the left mouse button
+G - switch the profile between the GPU curve and the polyline
 
 When body created:
 W - move forward
@@ -23,8 +43,20 @@ D - move right
 S - move backward
 Q - move down
 E - move up
+P - pick the surface point in front of the camera
+V - measure the tessellation error
+X - show the cross section by a plane in front of the camera
+[ and ] - move the section plane closer or farther
+O - export the body to body.glb
+T - switch to the tessellation shader renderer (GL 4.0)
+L - switch to the simplified mesh
 Mouse to look around
 
+At any time:
+Ctrl+Z - undo the last profile edit
+Ctrl+Y or Ctrl+Shift+Z - redo
+M - print the memory table
+
 */
 
 using namespace std;
@@ -50,11 +82,86 @@ Vector3 cameraUp = Vector3(0.0f, 1.0f, 0.0f);
 
 chrono::time_point<chrono::system_clock> g_callTime;
 
+// Frames are drawn only when something changed, at most maxFramesPerSecond times a second.
+// While idle the loop sleeps in glfwWaitEventsTimeout.
+const double maxFramesPerSecond = 60.0;
+const double idleTimeout = 0.5;
+const double maxDeltaTime = 0.1;
+
+bool g_viewChanged = true;
+Vector3 g_drawnCameraPos = Vector3(0.0f, 0.0f, 0.0f), g_drawnCameraFront = Vector3(0.0f, 0.0f, 0.0f);
+unsigned long long g_framesDrawn = 0, g_framesSkipped = 0;
+
+// --record <file> logs the input, --replay <file> plays it back with a fixed time step,
+// --headless keeps the window hidden during a replay, --bench runs the benchmarks and exits,
+// --check-allocations checks that edits do not allocate once warmed up and exits
+InputRecorder input;
+bool g_headless = false;
+const double replayTimeStep = 1.0 / 60.0;
+
+// CPU time of update and draw of every drawn frame, in milliseconds
+vector<double> g_frameTimes;
+
 bool keys[1024];
 
+int selectedPoint = -1;
+
 Points points;
 Curve curve;
 BodyOfRevolution bodyOfRevolution;
+RayCaster rayCaster;
+DistanceField distanceField;
+EditWorker editWorker;
+RevolutionMesh bodyMesh;
+FrameUniforms frameUniforms;
+Overlay overlay;
+RevolutionMesh simplifiedMesh;
+bool showSimplified = false;
+TessellatedBody tessellatedBody;
+bool useTessellation = false;
+
+// X cuts the body with a plane facing the camera at this distance (world units), the part in
+// front of it is clipped away. The section is recomputed from the profile whenever the view changes.
+CrossSection crossSection;
+bool showSection = false;
+float sectionDistance = 40.0f;
+const float sectionStep = 0.5f;
+
+// O writes the body as it is shown to a binary glTF file (EDIT_EXPORT_PATH) with quantized, compressed
+// buffers. The edit worker encodes and writes it and prints the report, the window keeps drawing.
+
+// K switches the edit mode between placing points and sketching the profile freehand.
+// A finished stroke is reduced to control points within this tolerance, in pixels.
+Sketch sketch;
+bool sketchMode = false;
+const double sketchTolerance = 3.0;
+
+// Ctrl+Z and Ctrl+Y step through the profile history kept by the edit worker. Edits wait until
+// the worker has answered every undo and redo, so the points never race a restored profile.
+int g_historyRequests = 0, g_historyRestores = 0;
+vector<Point2D> g_restoredProfile;
+
+// G switches the profile between the GPU-evaluated Bezier segments and the flattened polyline
+CurveRenderer curveRenderer;
+bool useGpuCurve = true;
+
+// The window title shows the live CPU and GPU memory, refreshed at this interval in seconds.
+// M prints the per-subsystem table to the console.
+const double memoryTitleInterval = 0.5;
+chrono::time_point<chrono::system_clock> g_memoryTitleTime;
+
+// The L key switches the body to a simplified mesh with this fraction of the triangles,
+// skipping collapses that move a vertex farther than the bound (profile units) from the original faces.
+// The edit worker simplifies the body, the mesh is shown once it is picked up in update().
+const int simplifyRatio = 8;
+const double simplifyMaxError = 2.0;
+
+// The V key measures how far the body mesh deviates from the exact surface and recommends
+// the cheapest tessellation within this Hausdorff distance (profile units)
+const double tessellationTolerance = 0.5;
+
+// The camera is kept at least this far from the body surface, in world units
+const float cameraRadius = 0.5f;
 
 GLuint createShader(const GLchar* code, GLenum type);
 
@@ -62,8 +169,24 @@ GLuint createProgram(GLuint vsh, GLuint fsh);
 
 bool init();
 
+void update();
+
+bool needsRedraw();
+
+bool cameraMoving();
+
+void createBody();
+
+void updateBodyQueries();
+
+bool profileEditable();
+
+void requestHistory(EditCommandType type);
+
 void reshape(GLFWwindow* window, int width, int height);
 
+void refresh(GLFWwindow* window);
+
 void draw(double deltaTime);
 
 void cleanup();
@@ -80,6 +203,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
+void edit_cursor_callback(GLFWwindow* window, double xpos, double ypos);
+
 void do_movement(double deltaTime);
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -88,8 +213,28 @@ Matrix4 createProjectionMatrix(float far, float near, float fov, int width, int
 
 Matrix4 g_P = createProjectionMatrix(100.0f, 0.1f, 40.0f, screen_width, screen_height, g_proj);
 
-int main()
+int main(int argc, char* argv[])
 {
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            if (!input.startRecording(argv[++i]))
+                return -1;
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            if (!input.startReplay(argv[++i]))
+                return -1;
+        }
+        else if (strcmp(argv[i], "--headless") == 0)
+            g_headless = true;
+        else if (strcmp(argv[i], "--bench") == 0)
+            return runBenchmarks() ? 0 : -1;
+        else if (strcmp(argv[i], "--check-allocations") == 0)
+            return checkAllocations() ? 0 : -1;
+    }
+
     // Initialize OpenGL
     if (!initOpenGL())
         return -1;
@@ -100,8 +245,12 @@ int main()
     if (isOk)
     {
 
-        glfwSetKeyCallback(g_window, key_callback);
-        glfwSetMouseButtonCallback(g_window, mouse_button_callback);
+        input.attach(g_window);
+        input.setKeyCallback(key_callback);
+        input.setMouseButtonCallback(mouse_button_callback);
+        input.setCursorCallback(edit_cursor_callback);
+
+        editWorker.start();
 
         g_callTime = chrono::system_clock::now();
 
@@ -112,17 +261,87 @@ int main()
             chrono::duration<double> elapsed = callTime - g_callTime;
             g_callTime = callTime;
 
-            double deltaTime = elapsed.count();
-            // Draw scene.
-            draw(deltaTime);
+            // Long idle waits must not turn into a jump of the camera
+            double deltaTime = elapsed.count() < maxDeltaTime ? elapsed.count() : maxDeltaTime;
+
+            if (input.replaying())
+            {
+                if (!input.beginFrame())
+                    break;
+
+                // A replay does not depend on timing: fixed steps and every edit applied before the frame
+                deltaTime = replayTimeStep;
+                editWorker.wait();
+            }
+            else
+                input.recordFrame(deltaTime);
+
+            // Take over geometry from the edit worker.
+            update();
+
+            if (needsRedraw())
+            {
+                // Draw scene.
+                draw(deltaTime);
+
+                // Swap buffers.
+                if (g_headless)
+                    glFinish();
+                else
+                    glfwSwapBuffers(g_window);
+
+                g_framesDrawn++;
+                g_frameTimes.push_back(chrono::duration<double, milli>(chrono::system_clock::now() - callTime).count());
+            }
+            else
+                g_framesSkipped++;
+
+            if (input.replaying())
+            {
+                // Feed the events of this frame instead of waiting for the window.
+                input.dispatchEvents();
+                glfwPollEvents();
+            }
+            else if (cameraMoving())
+            {
+                // Cap the frame rate while the camera flies, then poll window events.
+                chrono::duration<double> frameTime = chrono::system_clock::now() - callTime;
+                if (frameTime.count() < 1.0 / maxFramesPerSecond)
+                    this_thread::sleep_for(chrono::duration<double>(1.0 / maxFramesPerSecond - frameTime.count()));
 
-            // Swap buffers.
-            glfwSwapBuffers(g_window);
-            // Poll window events.
-            glfwPollEvents();
+                glfwPollEvents();
+            }
+            else
+                // Sleep until input, a worker result or the timeout arrives.
+                glfwWaitEventsTimeout(idleTimeout);
 
             do_movement(deltaTime);
         }
+
+        editWorker.stop();
+        input.finish();
+
+        cout << "Frames drawn " << g_framesDrawn << ", skipped " << g_framesSkipped << endl;
+
+        if (!g_frameTimes.empty())
+        {
+            sort(g_frameTimes.begin(), g_frameTimes.end());
+
+            double total = 0.0;
+            for (double time : g_frameTimes)
+                total += time;
+
+            cout << "Frame time average " << total / g_frameTimes.size() << " ms, median " << g_frameTimes[g_frameTimes.size() / 2]
+                << " ms, 95th percentile " << g_frameTimes[g_frameTimes.size() * 95 / 100] << " ms, max " << g_frameTimes.back() << " ms" << endl;
+        }
+
+        cout << "Curve updates " << editWorker.curveUpdates << ", meshes built " << editWorker.meshBuilds
+            << " in " << editWorker.meshMilliseconds << " ms, history cache hits " << editWorker.cacheHits << endl;
+
+        GLStateStats binds = GLState::total();
+        cout << "State changes issued " << binds.issued << ", elided " << binds.elided << endl;
+
+        MemoryRegistry::print();
     }
 
     // Cleanup graphical resources.
@@ -140,10 +359,136 @@ bool init()
 
     glEnable(GL_DEPTH_TEST);
 
-    bool pointsProgramCreated = points.createShaderProgram() && points.createModel();
-    bool curveProgramCreated = curve.createShaderProgram() && curve.createModel();
+    if (!frameUniforms.create())
+        return false;
+
+    curve.reserve(EDIT_RESERVE_POINTS);
+
+    // Without GL 4 the body is always drawn from the CPU mesh
+    if (!tessellatedBody.create())
+        cout << "Tessellation shaders are not available, using the mesh renderer" << endl;
+
+    return overlay.create() && curveRenderer.create() && crossSection.create();
+}
+
+void update()
+{
+    // Geometry finished by the edit worker is uploaded once per frame
+    if (editWorker.receiveProfile(g_restoredProfile, g_historyRestores))
+    {
+        selectedPoint = -1;
+        while (points.numberOfPoints > 0)
+            points.pop();
+        for (const Point2D& p : g_restoredProfile)
+            points.add(Vector2(p.x, p.y));
+    }
+
+    if (editWorker.receive(curve, bodyMesh))
+        createBody();
+
+    if (editWorker.receiveSimplified(simplifiedMesh))
+    {
+        showSimplified = true;
+        bodyOfRevolution.updateModel(simplifiedMesh);
+    }
+
+    // Only the control points of changed segments are uploaded
+    curveRenderer.update(curve);
+
+    // The stroke is sampled once per frame instead of on every cursor event
+    if (sketch.active)
+    {
+        double xpos, ypos;
+        input.getCursorPos(&xpos, &ypos);
+        sketch.sample(Point2D(xpos, (double)screen_height - ypos));
+    }
+
+    // Render thread side memory, the edit worker reports its own
+    MemoryRegistry::setCpuBytes(MemorySubsystem::points, points.memoryBytes() + sketch.memoryBytes());
+    MemoryRegistry::setCpuBytes(MemorySubsystem::curve, curve.memoryBytes() + curveRenderer.memoryBytes());
+    MemoryRegistry::setCpuBytes(MemorySubsystem::body, bodyMesh.memoryBytes() + simplifiedMesh.memoryBytes());
+    MemoryRegistry::setCpuBytes(MemorySubsystem::overlay, overlay.memoryBytes());
+    MemoryRegistry::setCpuBytes(MemorySubsystem::section, crossSection.memoryBytes());
+
+    auto now = chrono::system_clock::now();
+    if (chrono::duration<double>(now - g_memoryTitleTime).count() >= memoryTitleInterval)
+    {
+        g_memoryTitleTime = now;
+        glfwSetWindowTitle(g_window, ("Bodies of Revolution OpenGL - " + MemoryRegistry::summary()).c_str());
+    }
+}
+
+bool needsRedraw()
+{
+    bool cameraChanged = false;
+    for (int i = 0; i < 3; i++)
+        cameraChanged = cameraChanged || cameraPos[i] != g_drawnCameraPos[i] || cameraFront[i] != g_drawnCameraFront[i];
+
+    return g_viewChanged || cameraChanged || points.dirty || curve.dirty || bodyOfRevolution.dirty || sketch.dirty;
+}
+
+bool cameraMoving()
+{
+    if (!bodyOfRevolution.bodyCreated)
+        return false;
+
+    return keys[GLFW_KEY_W] || keys[GLFW_KEY_A] || keys[GLFW_KEY_S] || keys[GLFW_KEY_D] || keys[GLFW_KEY_Q] || keys[GLFW_KEY_E];
+}
+
+void createBody()
+{
+    if (bodyOfRevolution.bodyCreated)
+    {
+        // Undo and redo in fly mode replace the geometry of the existing body
+        showSimplified = false;
+        bodyOfRevolution.updateModel(bodyMesh);
+        updateBodyQueries();
+        return;
+    }
+
+    bodyOfRevolution.createBodyOfRevolution(bodyMesh, cameraPos);
+    if (bodyOfRevolution.bodyCreated)
+    {
+        updateBodyQueries();
+
+        g_proj = Projection::perspective;
+        g_P = createProjectionMatrix(200.0f, 0.1f, 40.0f, screen_width, screen_height, g_proj);
+        g_viewChanged = true;
+        input.setCursorCallback(mouse_callback);
+        glfwSetInputMode(g_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        input.setMouseButtonCallback(NULL);
+    }
+}
+
+void updateBodyQueries()
+{
+    Matrix4 model = bodyOfRevolution.getModelMatrix();
+    rayCaster.build(curve.segments, model);
+    distanceField.build(curve.segments, model);
+    tessellatedBody.build(curve.segments);
+
+    MassProperties mass = computeMassProperties(curve.segments);
+    cout << "Volume " << mass.volume << ", surface area " << mass.surfaceArea
+        << ", centroid x " << mass.centroidX << " (profile units)" << endl;
+}
+
+bool profileEditable()
+{
+    return g_historyRestores == g_historyRequests;
+}
+
+void requestHistory(EditCommandType type)
+{
+    if (sketch.active)
+        return;
+
+    // A drag in progress is recorded first, so undo steps back over the drag alone and redo restores it
+    if (selectedPoint >= 0)
+        editWorker.push({ EditCommandType::checkpoint, 0, 0.0, 0.0 });
 
-    return pointsProgramCreated;
+    selectedPoint = -1;
+    g_historyRequests++;
+    editWorker.push({ type, 0, 0.0, 0.0 });
 }
 
 void reshape(GLFWwindow* window, int width, int height)
@@ -154,28 +499,90 @@ void reshape(GLFWwindow* window, int width, int height)
     screen_height = height;
 
     g_P = createProjectionMatrix(200.0f, 0.1f, 40.0f, screen_width, screen_height, g_proj);
+
+    g_viewChanged = true;
+}
+
+// Exposed or uncovered parts of the window are drawn again on the next pass of the loop
+void refresh(GLFWwindow* window)
+{
+    g_viewChanged = true;
 }
 
 void draw(double deltaTime)
 {
+    GLState::beginFrame();
+
     // Clear color buffer.
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    // View and projection are shared by every program through one uniform buffer
+    Mat4f view = Mat4f::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    frameUniforms.update(view, Mat4f(g_P.elements));
+
+    // Some drivers clip on written distances even with GL_CLIP_DISTANCE0 disabled, so the plane
+    // is reset to one that keeps everything when there is no section
+    static const float noClipPlane[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const float* clipPlane = noClipPlane;
 
-    bodyOfRevolution.draw(deltaTime, g_P, cameraPos, cameraFront, cameraUp);
+    bool section = showSection && bodyOfRevolution.bodyCreated;
+    if (section)
+    {
+        // Plane facing the camera, positive behind it; cameraFront is kept normalized
+        Vector3 origin = cameraPos + cameraFront * sectionDistance;
+        double plane[4] = { cameraFront[0], cameraFront[1], cameraFront[2], -Vector3::dot(cameraFront, origin) };
+
+        Matrix4 model = bodyOfRevolution.getModelMatrix();
+        crossSection.build(curve.segments, plane, model);
+
+        clipPlane = crossSection.plane;
+        glEnable(GL_CLIP_DISTANCE0);
+    }
+
+    copy(clipPlane, clipPlane + 4, bodyOfRevolution.clipPlane);
+    copy(clipPlane, clipPlane + 4, tessellatedBody.clipPlane);
+
+    if (useTessellation && tessellatedBody.supported && bodyOfRevolution.bodyCreated)
+        tessellatedBody.draw(view, Mat4f(bodyOfRevolution.getModelMatrix().elements), screen_width, screen_height);
+    else
+        bodyOfRevolution.draw(deltaTime, view);
+
+    if (section)
+    {
+        glDisable(GL_CLIP_DISTANCE0);
+        crossSection.draw(Mat4f(bodyOfRevolution.getModelMatrix().elements));
+    }
     
     if(!bodyOfRevolution.bodyCreated)
     {
-        Matrix4 lookAt = createLookAtMatrix(cameraPos, cameraPos + cameraFront, cameraUp);
-        points.draw(deltaTime, lookAt, g_P);
-        curve.draw(deltaTime, lookAt, g_P);
-    }  
+        // Edit-mode geometry goes to the GPU in one buffer and two draw calls
+        overlay.begin();
+        points.addToOverlay(overlay);
+        if (!useGpuCurve)
+            curve.addToOverlay(overlay);
+        sketch.addToOverlay(overlay);
+        overlay.draw();
+
+        if (useGpuCurve)
+            curveRenderer.draw();
+    }
+
+    // Everything that changed is on screen now
+    g_viewChanged = false;
+    g_drawnCameraPos = cameraPos;
+    g_drawnCameraFront = cameraFront;
+    points.dirty = curve.dirty = bodyOfRevolution.dirty = sketch.dirty = false;
 }
 
 void cleanup()
 {
+    editWorker.stop();
     bodyOfRevolution.cleanup();
-    points.cleanup();
-    curve.cleanup();
+    overlay.cleanup();
+    curveRenderer.cleanup();
+    tessellatedBody.cleanup();
+    crossSection.cleanup();
+    frameUniforms.cleanup();
 }
 
 bool initOpenGL()
@@ -187,15 +594,29 @@ bool initOpenGL()
         return false;
     }
 
-    // Request OpenGL 3.3 without obsoleted functions.
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    // Request OpenGL 4.0 for tessellation shaders without obsoleted functions.
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    // The cross section cap is filled through the stencil buffer.
+    glfwWindowHint(GLFW_STENCIL_BITS, 8);
+
+    // A headless replay renders into a hidden window.
+    if (g_headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     // Create window.
     g_window = glfwCreateWindow(screen_width, screen_height, "Bodies of Revolution OpenGL", NULL, NULL);
     if (g_window == NULL)
+    {
+        // Fall back to OpenGL 3.3, the body is drawn from the CPU mesh then.
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        g_window = glfwCreateWindow(screen_width, screen_height, "Bodies of Revolution OpenGL", NULL, NULL);
+    }
+    if (g_window == NULL)
     {
         cout << "Failed to open GLFW window" << endl;
         glfwTerminate();
@@ -221,6 +642,9 @@ bool initOpenGL()
     // Set callback for framebuffer resizing event.
     glfwSetFramebufferSizeCallback(g_window, reshape);
 
+    // Set callback for window damage, the idle loop would otherwise leave it unpainted.
+    glfwSetWindowRefreshCallback(g_window, refresh);
+
     return true;
 }
 
@@ -246,30 +670,107 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         glfwSetWindowShouldClose(window, GL_TRUE);
 
     if (key == GLFW_KEY_ENTER && action == GLFW_PRESS)
-    {     
-        if (!bodyOfRevolution.bodyCreated)
-        {
-            bodyOfRevolution.createBodyOfRevolution(curve.points2D, cameraPos);
-            if (bodyOfRevolution.bodyCreated)
-            {
-                g_proj = Projection::perspective;
-                g_P = createProjectionMatrix(200.0f, 0.1f, 40.0f, screen_width, screen_height, g_proj);
-                glfwSetCursorPosCallback(g_window, mouse_callback);
-                glfwSetInputMode(g_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-                glfwSetMouseButtonCallback(g_window, NULL);
-            }
-        }      
+    {
+        // The body is created in update() once the worker has meshed it
+        if (!bodyOfRevolution.bodyCreated && points.numberOfPoints >= 2)
+            editWorker.push({ EditCommandType::buildBody, bodyOfRevolution.revolutions, 0.0, 0.0 });
     }
 
     if (key == GLFW_KEY_BACKSPACE && action == GLFW_PRESS)
     {
-        if (points.numberOfPoints >= 1)
+        if (points.numberOfPoints >= 1 && profileEditable())
         {
+            selectedPoint = -1;
             points.pop();
-            curve.calculateCurvePoints(points.point2DCenters);
+            editWorker.push({ EditCommandType::pop, 0, 0.0, 0.0 });
+            editWorker.push({ EditCommandType::checkpoint, 0, 0.0, 0.0 });
         }
     }
 
+    if (action == GLFW_PRESS && (mode & GLFW_MOD_CONTROL))
+    {
+        if (key == GLFW_KEY_Z && !(mode & GLFW_MOD_SHIFT))
+            requestHistory(EditCommandType::undo);
+        else if (key == GLFW_KEY_Y || key == GLFW_KEY_Z)
+            requestHistory(EditCommandType::redo);
+    }
+
+    if (key == GLFW_KEY_P && action == GLFW_PRESS && bodyOfRevolution.bodyCreated)
+    {
+        Ray ray;
+        ray.origin = cameraPos;
+        ray.direction = cameraFront;
+
+        RayHit hit = rayCaster.intersect(ray);
+        if (hit.hit)
+            cout << "Hit at (" << hit.point[0] << ", " << hit.point[1] << ", " << hit.point[2] << ")"
+                << " normal (" << hit.normal[0] << ", " << hit.normal[1] << ", " << hit.normal[2] << ")"
+                << " segment " << hit.segment << " u = " << hit.u << " distance " << hit.distance << endl;
+        else
+            cout << "No hit" << endl;
+    }
+
+    if (key == GLFW_KEY_K && action == GLFW_PRESS && !bodyOfRevolution.bodyCreated && !sketch.active)
+    {
+        sketchMode = !sketchMode;
+        selectedPoint = -1;
+        cout << (sketchMode ? "Sketch mode" : "Point mode") << endl;
+    }
+
+    if (key == GLFW_KEY_M && action == GLFW_PRESS)
+    {
+        MemoryRegistry::print();
+
+        GLStateStats binds = GLState::lastFrame();
+        cout << "Last frame: state changes issued " << binds.issued << ", elided " << binds.elided << endl;
+    }
+
+    if (key == GLFW_KEY_G && action == GLFW_PRESS && !bodyOfRevolution.bodyCreated)
+    {
+        useGpuCurve = !useGpuCurve;
+        g_viewChanged = true;
+    }
+
+    if (key == GLFW_KEY_T && action == GLFW_PRESS && bodyOfRevolution.bodyCreated)
+    {
+        useTessellation = tessellatedBody.supported && !useTessellation;
+        g_viewChanged = true;
+    }
+
+    if (key == GLFW_KEY_V && action == GLFW_PRESS && bodyOfRevolution.bodyCreated)
+    {
+        // Meshing every candidate takes a while, the edit worker measures and prints the reports
+        editWorker.push({ EditCommandType::measureTessellation, bodyOfRevolution.revolutions, tessellationTolerance, 0.0 });
+    }
+
+    if (key == GLFW_KEY_X && action == GLFW_PRESS && bodyOfRevolution.bodyCreated)
+    {
+        showSection = !showSection;
+        g_viewChanged = true;
+    }
+
+    if ((key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET) && action != GLFW_RELEASE && showSection)
+    {
+        sectionDistance = max(sectionDistance + (key == GLFW_KEY_LEFT_BRACKET ? -sectionStep : sectionStep), sectionStep);
+        g_viewChanged = true;
+    }
+
+    if (key == GLFW_KEY_O && action == GLFW_PRESS && bodyOfRevolution.bodyCreated)
+    {
+        editWorker.push({ EditCommandType::exportBody, showSimplified ? 1 : 0, 0.0, 0.0 });
+    }
+
+    if (key == GLFW_KEY_L && action == GLFW_PRESS && bodyOfRevolution.bodyCreated)
+    {
+        if (showSimplified)
+        {
+            showSimplified = false;
+            bodyOfRevolution.updateModel(bodyMesh);
+        }
+        else
+            editWorker.push({ EditCommandType::simplifyBody, simplifyRatio, simplifyMaxError, 0.0 });
+    }
+
     if (bodyOfRevolution.bodyCreated)
     {
         if (action == GLFW_PRESS)
@@ -281,16 +782,65 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+    if (sketchMode)
     {
         double xpos, ypos;
-        glfwGetCursorPos(g_window, &xpos, &ypos);
+        input.getCursorPos(&xpos, &ypos);
+        Point2D point(xpos, (double)screen_height - ypos);
+
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && profileEditable())
+            sketch.begin(point);
+
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE && sketch.active)
+        {
+            sketch.sample(point);
+
+            // The worker drains queued commands in batches and recomputes the curve once per batch
+            for (const Point2D& p : sketch.finish(sketchTolerance))
+            {
+                points.add(Vector2(p.x, p.y));
+                editWorker.push({ EditCommandType::add, 0, p.x, p.y });
+            }
+
+            // The whole stroke is one undo step
+            editWorker.push({ EditCommandType::checkpoint, 0, 0.0, 0.0 });
+        }
+        return;
+    }
+
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && profileEditable())
+    {
+        double xpos, ypos;
+        input.getCursorPos(&xpos, &ypos);
         float sx = xpos;
         float sy = ((float)screen_height - ypos);
-        points.add(Vector2(sx, sy));
 
-        curve.calculateCurvePoints(points.point2DCenters);
+        selectedPoint = points.pick(Vector2(sx, sy));
+        if (selectedPoint < 0)
+        {
+            points.add(Vector2(sx, sy));
+            editWorker.push({ EditCommandType::add, 0, sx, sy });
+            editWorker.push({ EditCommandType::checkpoint, 0, 0.0, 0.0 });
+        }
     }
+
+    // A drag is one undo step
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE && selectedPoint >= 0)
+    {
+        selectedPoint = -1;
+        editWorker.push({ EditCommandType::checkpoint, 0, 0.0, 0.0 });
+    }
+}
+
+void edit_cursor_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (selectedPoint < 0)
+        return;
+
+    float sx = xpos;
+    float sy = ((float)screen_height - ypos);
+    points.move(selectedPoint, Vector2(sx, sy));
+    editWorker.push({ EditCommandType::move, selectedPoint, sx, sy });
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -331,19 +881,30 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 void do_movement(double deltaTime)
 {
     GLfloat cameraSpeed = 40.0f * deltaTime;
+    Vector3 position = cameraPos;
 
     if (keys[GLFW_KEY_W])
-        cameraPos = cameraPos + cameraSpeed * cameraFront;
+        position = position + cameraSpeed * cameraFront;
     if (keys[GLFW_KEY_S])
-        cameraPos = cameraPos - cameraSpeed * cameraFront;
+        position = position - cameraSpeed * cameraFront;
     if (keys[GLFW_KEY_A])
-        cameraPos = cameraPos - Vector3::normalize(Vector3::cross(cameraFront, cameraUp)) * cameraSpeed;
+        position = position - Vector3::normalize(Vector3::cross(cameraFront, cameraUp)) * cameraSpeed;
     if (keys[GLFW_KEY_D])
-        cameraPos = cameraPos + Vector3::normalize(Vector3::cross(cameraFront, cameraUp)) * cameraSpeed;
+        position = position + Vector3::normalize(Vector3::cross(cameraFront, cameraUp)) * cameraSpeed;
     if (keys[GLFW_KEY_Q])
-        cameraPos = cameraPos - cameraUp * cameraSpeed;
+        position = position - cameraUp * cameraSpeed;
     if (keys[GLFW_KEY_E])
-        cameraPos = cameraPos + cameraUp * cameraSpeed;
+        position = position + cameraUp * cameraSpeed;
+
+    // Do not let the camera move into the body, moving away from it is always allowed
+    if (bodyOfRevolution.bodyCreated)
+    {
+        float distance = distanceField.distance(position);
+        if (distance < cameraRadius && distance < distanceField.distance(cameraPos))
+            return;
+    }
+
+    cameraPos = position;
 }
 
 Matrix4 createProjectionMatrix(float far, float near, float fov, int width, int height, Projection proj)
@@ -1,4 +1,10 @@
 #include "tbezier.h"
+#include "Parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TBEZIER_SSE
+#endif
 
 bool IS_ZERO(double v)
 {
@@ -37,7 +43,7 @@ Point2D Point2D::absMin(const Point2D& p1, const Point2D& p2)
     return Point2D(abs(p1.x) < abs(p2.x) ? p1.x : p2.x, abs(p1.y) < abs(p2.y) ? p1.y : p2.y);
 };
 
-Point2D Segment::calc(double t)
+Point2D Segment::calc(double t) const
 {
     double t2 = t * t;
     double t3 = t2 * t;
@@ -48,6 +54,120 @@ Point2D Segment::calc(double t)
         nt3 * points[0].y + 3.0 * t * nt2 * points[1].y + 3.0 * t2 * nt * points[2].y + t3 * points[3].y);
 }
 
+Point2D Segment::derivative(double t) const
+{
+    double t2 = t * t;
+    double nt = 1.0 - t;
+    double nt2 = nt * nt;
+    return Point2D(3.0 * (nt2 * (points[1].x - points[0].x) + 2.0 * t * nt * (points[2].x - points[1].x) + t2 * (points[3].x - points[2].x)),
+        3.0 * (nt2 * (points[1].y - points[0].y) + 2.0 * t * nt * (points[2].y - points[1].y) + t2 * (points[3].y - points[2].y)));
+}
+
+Point2D Segment::tangent(double t) const
+{
+    Point2D d = derivative(t);
+    if (IS_ZERO(d.x) && IS_ZERO(d.y))
+        d = t < 0.5 ? points[2] - points[0] : points[3] - points[1];
+    if (IS_ZERO(d.x) && IS_ZERO(d.y))
+        d = points[3] - points[0];
+    d.normalize();
+    return d;
+}
+
+// Tangent at a point from the normalized directions of the chords before and after it
+static Point2D selectTangent(const Point2D& cur, const Point2D& next)
+{
+    Point2D tg;
+    if (IS_ZERO(cur.x) || IS_ZERO(cur.y))
+        tg = cur;
+    else if (IS_ZERO(next.x) || IS_ZERO(next.y))
+        tg = next;
+    else
+        tg = cur + next;
+    tg.normalize();
+
+    return tg;
+}
+
+static Point2D tangentAt(const std::vector<Point2D>& values, int j)
+{
+    int n = values.size() - 1;
+
+    if (j <= 0 || j >= n)
+        return Point2D();
+
+    Point2D cur = values[j] - values[j - 1];
+    cur.normalize();
+
+    Point2D next = values[j + 1] - values[j];
+    next.normalize();
+
+    return selectTangent(cur, next);
+}
+
+static void clampTangent(Point2D& tg, const Point2D& deltaC)
+{
+    if (SIGN(tg.x) != SIGN(deltaC.x))
+        tg.x = 0.0;
+    if (SIGN(tg.y) != SIGN(deltaC.y))
+        tg.y = 0.0;
+}
+
+static void buildSegment(const std::vector<Point2D>& values, int i, Point2D& tgL, Point2D& tgR, Segment& segment)
+{
+    Point2D deltaC;
+    double l1, l2;
+    bool zL, zR;
+
+    deltaC = values[i + 1] - values[i]; //   PiPi+1
+
+    // There is actually a little mistake in the white paper (http://sv-journal.org/2017-1/04.php?lang=en):
+    // algorithm described after figure 14 implicitly assumes that tangent vectors point inside the
+    // A_i and B_i areas (see fig. 14). However in practice they can point outside as well. If so, tangents
+    // coordinates should be clamped to the border of A_i or B_i respectively to keep control points inside
+    // the described area and thereby to avoid false extremes and loops on the curve.
+    // The clamping is implemented by clampTangent.
+    clampTangent(tgL, deltaC);
+    clampTangent(tgR, deltaC);
+
+    zL = IS_ZERO(tgL.x);
+    zR = IS_ZERO(tgR.x);
+
+    //       
+
+    l1 = zL ? 0.0 : deltaC.x / (C * tgL.x);
+    l2 = zR ? 0.0 : deltaC.x / (C * tgR.x);
+
+    if (abs(l1 * tgL.y) > abs(deltaC.y))
+        l1 = IS_ZERO(tgL.y) ? 0.0 : deltaC.y / tgL.y;
+    if (abs(l2 * tgR.y) > abs(deltaC.y))
+        l2 = IS_ZERO(tgR.y) ? 0.0 : deltaC.y / tgR.y;
+
+    // ,    
+
+    /*if (!zL && !zR)
+    {
+        tmp = tgL.y / tgL.x - tgR.y / tgR.x;
+        if (!IS_ZERO(tmp))
+        {
+            x = (values[i + 1].y - tgR.y / tgR.x * values[i + 1].x - values[i].y + tgL.y / tgL.x * values[i].x) / tmp;
+            if (x > values[i].x && x < values[i + 1].x)
+            {
+                if (abs(l1) > abs(l2))
+                    l1 = 0.0;
+                else
+                    l2 = 0.0;
+            }
+        }
+    }*/
+
+    //    
+    segment.points[0] = values[i];
+    segment.points[1] = segment.points[0] + tgL * l1;
+    segment.points[3] = values[i + 1];
+    segment.points[2] = segment.points[3] - tgR * l2;
+}
+
 bool tbezierSO0(const std::vector<Point2D>& values, std::vector<Segment>& curve)
 {
     int n = values.size() - 1;
@@ -57,9 +177,7 @@ bool tbezierSO0(const std::vector<Point2D>& values, std::vector<Segment>& curve)
 
     curve.resize(n);
 
-    Point2D cur, next, tgL, tgR, deltaC;
-    double l1, l2, tmp, x;
-    bool zL, zR;
+    Point2D cur, next, tgL, tgR;
 
     next = values[1] - values[0];
     next.normalize();
@@ -69,80 +187,129 @@ bool tbezierSO0(const std::vector<Point2D>& values, std::vector<Segment>& curve)
         tgL = tgR;
         cur = next;
 
-        deltaC = values[i + 1] - values[i]; //   PiPi+1
-
-
         //     
 
         if (i < n - 1)
         {
             next = values[i + 2] - values[i + 1];
             next.normalize();
-            if (IS_ZERO(cur.x) || IS_ZERO(cur.y))
-                tgR = cur;
-            else if (IS_ZERO(next.x) || IS_ZERO(next.y))
-                tgR = next;
-            else
-                tgR = cur + next;
-            tgR.normalize();
+            tgR = selectTangent(cur, next);
         }
         else
         {
             tgR = Point2D();
         }
 
-        // There is actually a little mistake in the white paper (http://sv-journal.org/2017-1/04.php?lang=en):
-        // algorithm described after figure 14 implicitly assumes that tangent vectors point inside the
-        // A_i and B_i areas (see fig. 14). However in practice they can point outside as well. If so, tangents
-        // coordinates should be clamped to the border of A_i or B_i respectively to keep control points inside
-        // the described area and thereby to avoid false extremes and loops on the curve.
-        // The clamping is implemented by the next 4 if-statements.
-        if (SIGN(tgL.x) != SIGN(deltaC.x))
-            tgL.x = 0.0;
-        if (SIGN(tgL.y) != SIGN(deltaC.y))
-            tgL.y = 0.0;
-        if (SIGN(tgR.x) != SIGN(deltaC.x))
-            tgR.x = 0.0;
-        if (SIGN(tgR.y) != SIGN(deltaC.y))
-            tgR.y = 0.0;
-
-        zL = IS_ZERO(tgL.x);
-        zR = IS_ZERO(tgR.x);
-
-        //       
-
-        l1 = zL ? 0.0 : deltaC.x / (C * tgL.x);
-        l2 = zR ? 0.0 : deltaC.x / (C * tgR.x);
-
-        if (abs(l1 * tgL.y) > abs(deltaC.y))
-            l1 = IS_ZERO(tgL.y) ? 0.0 : deltaC.y / tgL.y;
-        if (abs(l2 * tgR.y) > abs(deltaC.y))
-            l2 = IS_ZERO(tgR.y) ? 0.0 : deltaC.y / tgR.y;
-
-        // ,    
-
-        /*if (!zL && !zR)
-        {
-            tmp = tgL.y / tgL.x - tgR.y / tgR.x;
-            if (!IS_ZERO(tmp))
-            {
-                x = (values[i + 1].y - tgR.y / tgR.x * values[i + 1].x - values[i].y + tgL.y / tgL.x * values[i].x) / tmp;
-                if (x > values[i].x && x < values[i + 1].x)
-                {
-                    if (abs(l1) > abs(l2))
-                        l1 = 0.0;
-                    else
-                        l2 = 0.0;
-                }
-            }
-        }*/
+        buildSegment(values, i, tgL, tgR, curve[i]);
+    }
 
-        //    
-        curve[i].points[0] = values[i];
-        curve[i].points[1] = curve[i].points[0] + tgL * l1;
-        curve[i].points[3] = values[i + 1];
-        curve[i].points[2] = curve[i].points[3] - tgR * l2;
+    return true;
+}
+
+bool tbezierSO0(const std::vector<Point2D>& values, std::vector<Segment>& curve, int first, int last)
+{
+    int n = values.size() - 1;
+
+    if (n < 2 || (int)curve.size() != n)
+        return false;
+
+    if (first < 0)
+        first = 0;
+    if (last > n)
+        last = n;
+
+    for (int i = first; i < last; ++i)
+    {
+        // The serial version carries tgR already clamped by the previous segment into tgL
+        Point2D tgL = tangentAt(values, i);
+        if (i > 0)
+            clampTangent(tgL, values[i] - values[i - 1]);
+
+        Point2D tgR = tangentAt(values, i + 1);
+
+        buildSegment(values, i, tgL, tgR, curve[i]);
     }
 
     return true;
 }
+
+// Tangents at the points [first; last), 0 < first. Chords are normalized in pairs: the SSE path
+// uses the same operations as Point2D::normalize, so the results are identical.
+static void computeTangents(const std::vector<Point2D>& values, int first, int last, Point2D* tangents)
+{
+    Point2D cur = values[first] - values[first - 1];
+    cur.normalize();
+
+    int j = first;
+
+#ifdef TBEZIER_SSE
+    const __m128d epsilon = _mm_set1_pd(EPSILON);
+
+    for (; j + 2 <= last; j += 2)
+    {
+        // Chords after the points j and j + 1
+        __m128d x = _mm_set_pd(values[j + 2].x - values[j + 1].x, values[j + 1].x - values[j].x);
+        __m128d y = _mm_set_pd(values[j + 2].y - values[j + 1].y, values[j + 1].y - values[j].y);
+        __m128d l = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)));
+
+        // Zero length chords become zero vectors, like IS_ZERO(l) in normalize
+        __m128d keep = _mm_cmpnlt_pd(l, epsilon);
+        x = _mm_and_pd(_mm_div_pd(x, l), keep);
+        y = _mm_and_pd(_mm_div_pd(y, l), keep);
+
+        Point2D next0, next1;
+        _mm_storel_pd(&next0.x, x);
+        _mm_storel_pd(&next0.y, y);
+        _mm_storeh_pd(&next1.x, x);
+        _mm_storeh_pd(&next1.y, y);
+
+        tangents[j] = selectTangent(cur, next0);
+        tangents[j + 1] = selectTangent(next0, next1);
+        cur = next1;
+    }
+#endif
+
+    for (; j < last; j++)
+    {
+        Point2D next = values[j + 1] - values[j];
+        next.normalize();
+
+        tangents[j] = selectTangent(cur, next);
+        cur = next;
+    }
+}
+
+bool tbezierSO0Parallel(const std::vector<Point2D>& values, std::vector<Segment>& curve, int minPoints)
+{
+    int n = values.size() - 1;
+
+    if (n < 2 || n + 1 < minPoints)
+        return tbezierSO0(values, curve);
+
+    curve.resize(n);
+
+    // Tangents at the end points stay zero, like in the serial version
+    std::vector<Point2D> tangents(n + 1);
+
+    parallelFor(n - 1, 4096, [&](int begin, int end)
+    {
+        computeTangents(values, begin + 1, end + 1, tangents.data());
+    });
+
+    parallelFor(n, 4096, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            // The serial version carries tgR already clamped by the previous segment into tgL
+            Point2D tgL = tangents[i];
+            if (i > 0)
+                clampTangent(tgL, values[i] - values[i - 1]);
+
+            Point2D tgR = tangents[i + 1];
+
+            buildSegment(values, i, tgL, tgR, curve[i]);
+        }
+    });
+
+    return true;
+}
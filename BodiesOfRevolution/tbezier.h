@@ -48,7 +48,43 @@ public:
      * @param t - parameter of the curve, should be in [0; 1].
      * @return intermediate Bezier curve point that corresponds the given parameter.
      */
-    Point2D calc(double t);
+    Point2D calc(double t) const;
+
+    /**
+     * Calculate the first derivative of the curve.
+     *
+     * @param t - parameter of the curve, should be in [0; 1].
+     * @return derivative vector dP/dt at the given parameter.
+     */
+    Point2D derivative(double t) const;
+
+    /**
+     * Calculate the unit tangent of the curve.
+     *
+     * When the derivative vanishes (a control point coincides with an end point) the direction
+     * of the next non-degenerate control polygon chord is used instead.
+     *
+     * @param t - parameter of the curve, should be in [0; 1].
+     * @return normalized tangent vector at the given parameter.
+     */
+    Point2D tangent(double t) const;
 };
 
-bool tbezierSO0(const std::vector<Point2D>& values, std::vector<Segment>& curve);
\ No newline at end of file
+bool tbezierSO0(const std::vector<Point2D>& values, std::vector<Segment>& curve);
+
+/**
+ * Recalculate the segments [first; last) of a curve previously built by tbezierSO0 from the same
+ * number of values. The result is identical to rebuilding the whole curve.
+ */
+bool tbezierSO0(const std::vector<Point2D>& values, std::vector<Segment>& curve, int first, int last);
+
+// Default size below which tbezierSO0Parallel runs tbezierSO0. Not tuned yet: the extra tangent pass
+// costs about 1.3x on one core, and the editor calls tbezierSO0 until --bench shows a gain.
+#define TBEZIER_PARALLEL_MIN 16384
+
+/**
+ * Same result as tbezierSO0, bit for bit, for large inputs: per-point tangents are computed in one
+ * data-parallel pass and the segments in a second one, both split across threads.
+ * Inputs with fewer than minPoints points run the serial version.
+ */
+bool tbezierSO0Parallel(const std::vector<Point2D>& values, std::vector<Segment>& curve, int minPoints = TBEZIER_PARALLEL_MIN);
\ No newline at end of file